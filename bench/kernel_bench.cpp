@@ -0,0 +1,82 @@
+/**
+ * @file kernel_bench.cpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ * @brief Checks every supported NaSch kernel against the scalar one and NSRules, then times them
+ *        Usage: bench_kernel [cars] [iterations] [vmax]
+ */
+#include "NaschKernel.hpp"
+#include "Random.hpp"
+#include "Rules.hpp"
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using NaschKernel::Isa;
+
+int main(int argc, char* argv[]) {
+    int cars = argc > 1 ? std::atoi(argv[1]) : 4096;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 20000;
+    int vmax = argc > 3 ? std::atoi(argv[3]) : 5;
+    const double p = 0.3;
+
+    // Random lane state: velocities 0..vmax, gaps 1..vmax + 1 (as capped by the grid), braking draws
+    CounterRng rng(2024);
+    std::vector<int16_t> vel(cars), gap(cars), brake(cars);
+    std::vector<double> draws(cars);
+    for (int i = 0; i < cars; i++) {
+        vel[i] = static_cast<int16_t>(rng.below(vmax + 1, 0, i, RngStream::SpawnVelocity));
+        gap[i] = static_cast<int16_t>(1 + rng.below(vmax + 1, 0, i, RngStream::Spawn));
+        draws[i] = rng.uniform(0, i, RngStream::Braking);
+        brake[i] = draws[i] < p;
+    }
+
+    NSRules rules;
+    std::vector<int16_t> expected(cars);
+    for (int i = 0; i < cars; i++)
+        expected[i] = static_cast<int16_t>(rules.nextVelocity(vel[i], gap[i], vmax, p, draws[i]));
+
+    std::cout << cars << " cars, " << iterations << " iterations, vmax " << vmax
+              << ", best kernel " << NaschKernel::name(NaschKernel::best()) << "\n";
+
+    bool ok = true;
+    double scalarSeconds = 0.0;
+    for (Isa isa : {Isa::Scalar, Isa::SSE41, Isa::AVX2, Isa::AVX512}) {
+        if (!NaschKernel::supported(isa)) {
+            std::cout << std::left << std::setw(12) << NaschKernel::name(isa) << "not supported\n";
+            continue;
+        }
+
+        // Every length up to 64 covers all vector/tail splits
+        bool same = true;
+        for (int n = 0; n <= std::min(cars, 64) && same; n++) {
+            std::vector<int16_t> out(vel.begin(), vel.begin() + n);
+            NaschKernel::apply(out.data(), gap.data(), brake.data(), n, vmax, isa);
+            same = std::equal(out.begin(), out.end(), expected.begin());
+        }
+        std::vector<int16_t> out = vel;
+        NaschKernel::apply(out.data(), gap.data(), brake.data(), cars, vmax, isa);
+        same = same && out == expected;
+        ok = ok && same;
+
+        std::vector<int16_t> work = vel;
+        auto start = std::chrono::steady_clock::now();
+        for (int it = 0; it < iterations; it++) {
+            NaschKernel::apply(work.data(), gap.data(), brake.data(), cars, vmax, isa);
+            // Feed back so the loop cannot be hoisted, velocities stay within 0..vmax
+            work[it % cars] = vel[it % cars];
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (isa == Isa::Scalar)
+            scalarSeconds = seconds;
+
+        std::cout << std::left << std::setw(12) << NaschKernel::name(isa) << std::right << std::fixed
+                  << std::setw(8) << std::setprecision(3) << seconds * 1e9 / (double(iterations) * cars) << " ns/car"
+                  << std::setw(8) << std::setprecision(2) << scalarSeconds / seconds << "x"
+                  << "   " << (same ? "matches NSRules" : "MISMATCH") << "\n";
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file logging_bench.cpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ * @brief Compares a logged Simulation step with sampled logging and the headless one (logging hooks compiled out)
+ *        Usage: bench_logging [width] [height] [steps] [vmax]
+ */
+#include "Simulation.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+
+struct BenchResult {
+    double seconds;
+    int carsExited;     ///< Exited cars after the last step (both modes must agree)
+};
+
+/**
+ * @brief Runs a fresh simulation for the configured number of steps
+ */
+BenchResult run(SimulationConfig config, bool headless) {
+    config.headless = headless;
+    Simulation sim(config);
+
+    auto start = std::chrono::steady_clock::now();
+    while (!sim.finished())
+        sim.step();
+    auto end = std::chrono::steady_clock::now();
+
+    return {std::chrono::duration<double>(end - start).count(), sim.getGrid().getCarsEntered() - sim.getGrid().getCarsInSystem()};
+}
+
+void report(const std::string& name, const BenchResult& r, int steps, double baseline) {
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed
+              << std::setw(10) << std::setprecision(3) << r.seconds * 1e3 / steps << " ms/step"
+              << std::setw(8) << std::setprecision(2) << baseline / r.seconds << "x"
+              << "   exited " << r.carsExited << "\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    SimulationConfig config;
+    config.width = argc > 1 ? std::atoi(argv[1]) : 400;
+    config.height = argc > 2 ? std::atoi(argv[2]) : 400;
+    config.steps = argc > 3 ? std::atoi(argv[3]) : 3000;
+    config.vmax = argc > 4 ? std::atoi(argv[4]) : 5;
+    config.seed = 12345;
+
+    std::cout << "Grid " << config.width << "x" << config.height << ", " << config.steps << " steps, vmax " << config.vmax << "\n";
+
+    BenchResult logged = run(config, false);
+    report("logged", logged, config.steps, logged.seconds);
+
+    SimulationConfig sampled = config;
+    sampled.sampling.stride = 10;
+    sampled.sampling.vehicleRate = 0.1;
+    report("logged, every 10th step/car", run(sampled, false), config.steps, logged.seconds);
+    sampled.sampling.stride = 100;
+    sampled.sampling.vehicleRate = 0.0;
+    report("logged, every 100th step", run(sampled, false), config.steps, logged.seconds);
+
+    BenchResult headless = run(config, true);
+    report("headless", headless, config.steps, logged.seconds);
+    return 0;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file update_bench.cpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ * @brief Compares the virtual Rules path of Grid::update with the inlined NSRules paths
+ *        Usage: bench_update [width] [height] [steps] [vmax]
+ */
+#include "Grid.hpp"
+#include "Rules.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+
+constexpr uint64_t SEED = 12345;
+constexpr double PROB = 0.3;
+constexpr double DENSITY = 0.5;
+
+struct BenchResult {
+    double seconds;
+    long long carSteps;     ///< Sum of car counts over all steps
+    double avgVelocity;     ///< Average velocity after the last step (paths must agree)
+};
+
+/**
+ * @brief Runs a fresh grid for given number of steps using update function fn
+ */
+template <class Fn>
+BenchResult run(int width, int height, int steps, Fn fn) {
+    Grid grid(width, height);
+    grid.setSeed(SEED);
+    grid.initializeMap(DENSITY, false);
+    grid.setupCrossroadLights(25, 0, 20);
+
+    long long carSteps = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int step = 0; step < steps; step++) {
+        fn(grid, step);
+        carSteps += grid.getVehicles().size();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return {std::chrono::duration<double>(end - start).count(), carSteps, grid.averageVelocity()};
+}
+
+void report(const std::string& name, const BenchResult& r, int steps, double baseline) {
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed
+              << std::setw(10) << std::setprecision(3) << r.seconds * 1e3 / steps << " ms/step"
+              << std::setw(10) << std::setprecision(1) << r.seconds * 1e9 / r.carSteps << " ns/slot"
+              << std::setw(8) << std::setprecision(2) << baseline / r.seconds << "x"
+              << "   avg v " << std::setprecision(4) << r.avgVelocity << "\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int width = argc > 1 ? std::atoi(argv[1]) : 400;
+    int height = argc > 2 ? std::atoi(argv[2]) : 400;
+    int steps = argc > 3 ? std::atoi(argv[3]) : 3000;
+    int vmax = argc > 4 ? std::atoi(argv[4]) : 5;
+
+    std::cout << "Grid " << width << "x" << height << ", " << steps << " steps, vmax " << vmax << "\n";
+
+    NSRules nsRules;
+    const Rules& virtualRules = nsRules;
+
+    BenchResult virt = run(width, height, steps, [&](Grid& g, int step) {
+        g.update<Rules>(virtualRules, DENSITY, vmax, PROB, step);
+    });
+    BenchResult inlined = run(width, height, steps, [&](Grid& g, int step) {
+        g.update<NSRules>(nsRules, DENSITY, vmax, PROB, step);
+    });
+
+    report("virtual Rules", virt, steps, virt.seconds);
+    report("NSRules", inlined, steps, virt.seconds);
+
+    if (vmax == 3 || vmax == 5) {
+        BenchResult fixed = run(width, height, steps, [&](Grid& g, int step) {
+            if (vmax == 3) g.update<NSRules, 3>(nsRules, DENSITY, vmax, PROB, step);
+            else           g.update<NSRules, 5>(nsRules, DENSITY, vmax, PROB, step);
+        });
+        report("NSRules, compile-time vmax", fixed, steps, virt.seconds);
+    }
+
+    return 0;
+}
@@ -5,7 +5,10 @@
 #ifndef ARG_PARSER_HPP
 #define ARG_PARSER_HPP
 
+#include <array>
 #include <string>
+#include <vector>
+#include <cstdint>
 
 /**
  * @class ArgParser
@@ -45,6 +48,32 @@ public:
     double getProb() const { return prob; }
     double getDensity() const { return density; }
     bool getOptimize() const { return optimize; }
+    uint64_t getSeed() const { return seed; }
+    int getThreads() const { return threads; }
+    int getReplicas() const { return replicas; }
+    int getJobs() const { return jobs; }
+    double getCiTarget() const { return ciTarget; }
+    int getMaxReplicas() const { return maxReplicas; }
+    bool isEnsembleEnabled() const { return replicas > 1 || ciTarget > 0.0; }
+    const std::vector<std::string>& getSweepSpecs() const { return sweepSpecs; }
+    std::string getSweepFile() const { return sweepFile; }
+    bool isSweepEnabled() const { return !sweepSpecs.empty() || !sweepFile.empty(); }
+    std::string getTuneObjective() const { return tuneObjective; }
+    int getTuneStep() const { return tuneStep; }
+    int getTuneBudget() const { return tuneBudget; }
+    bool isTuneEnabled() const { return !tuneObjective.empty(); }
+    int getCheckpointEvery() const { return checkpointEvery; }
+    std::string getCheckpointFile() const { return checkpointFile; }
+    std::string getRestoreFile() const { return restoreFile; }
+    double getSteadyTarget() const { return steadyTarget; }
+    bool isHeadless() const { return headless; }
+    int getReportEvery() const { return reportEvery; }
+    bool isStreamEnabled() const { return stream; }
+    bool isColumnarEnabled() const { return columnar; }
+    std::string getPathsFile() const { return pathsFile; }
+    int getLogEvery() const { return logEvery; }
+    double getSampleVehicles() const { return sampleVehicles; }
+    const std::vector<std::array<int, 4>>& getHeatmapRegions() const { return heatmapRegions; }
 
 private:
     size_t argc;                    ///< Argument count
@@ -60,6 +89,29 @@ private:
     double prob = 0.3;              ///< Braking probability
     double density = 0.5;           ///< Initial car density (0-1)
     bool optimize = false;          ///< Add straight lane to east inbound and west outbound if true
+    uint64_t seed;                  ///< Random seed (drawn from std::random_device unless --seed is set)
+    int threads = 1;                ///< Threads used by the grid update
+    int replicas = 1;               ///< Number of replicas (ensemble mode if > 1)
+    int jobs = 1;                   ///< Replicas run in parallel
+    double ciTarget = 0.0;          ///< Relative 95% CI half-width to reach (0 = fixed replica count)
+    int maxReplicas = 200;          ///< Replica limit for ciTarget
+    std::vector<std::string> sweepSpecs;    ///< Swept parameter ranges (name=from:to:step or name=v1,v2,...)
+    std::string sweepFile;          ///< File with more sweep specs
+    std::string tuneObjective;      ///< Objective of the signal tuner (throughput or delay, empty = off)
+    int tuneStep = 16;              ///< First change of a green duration in the tuner
+    int tuneBudget = 200;           ///< Maximum number of plans the tuner evaluates
+    int checkpointEvery = 0;        ///< Steps between checkpoints (0 = no checkpoints)
+    std::string checkpointFile = "checkpoint.bin";  ///< File the latest checkpoint is written to
+    std::string restoreFile;        ///< Checkpoint the run continues from (empty = start from an empty map)
+    double steadyTarget = 0.0;      ///< Relative 95% CI half-width that ends a run early (0 = run all steps)
+    bool headless = false;          ///< Run without logging hooks (only counts and throughput are reported)
+    int reportEvery = 25;           ///< Steps between live summary tables (0 = only the final one)
+    bool stream = false;            ///< Write timesteps and trajectories of --plot while running
+    bool columnar = false;          ///< Export timesteps and trajectories of --plot as columnar binary files
+    std::string pathsFile;          ///< File every vehicle's position history is recorded to (empty = off)
+    int logEvery = 1;               ///< Stride of recorded timestep rows and heatmap observations
+    double sampleVehicles = 1.0;    ///< Fraction of vehicles the logger tracks (0-1)
+    std::vector<std::array<int, 4>> heatmapRegions;  ///< Heatmap regions x0, y0, x1, y1 (empty = whole grid)
 };
 
 #endif // ARG_PARSER_HPP
\ No newline at end of file
@@ -0,0 +1,65 @@
+/**
+ * @file BinaryIO.hpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#ifndef BINARY_IO_HPP
+#define BINARY_IO_HPP
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Raw little helpers for checkpoint files (values are written in host byte order,
+ *        a checkpoint is only meant to be read back on the same kind of machine)
+ */
+namespace BinaryIO
+{
+    /**
+     * @brief Writes a trivially copyable value
+     */
+    template <class T>
+    void write(std::ostream& out, const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "only raw values can be written");
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    /**
+     * @brief Reads a trivially copyable value
+     * @return False if the stream ended
+     */
+    template <class T>
+    bool read(std::istream& in, T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "only raw values can be read");
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+    /**
+     * @brief Writes element count and the elements of a vector of raw values
+     */
+    template <class T>
+    void writeVector(std::ostream& out, const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>, "only raw values can be written");
+        write(out, static_cast<uint64_t>(values.size()));
+        out.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+    }
+
+    /**
+     * @brief Reads a vector written by writeVector
+     * @return False if the stream ended
+     */
+    template <class T>
+    bool readVector(std::istream& in, std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>, "only raw values can be read");
+        uint64_t count = 0;
+        // A count this large only comes from a damaged file
+        if (!read(in, count) || count > (uint64_t{1} << 32))
+            return false;
+        values.resize(count);
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(count * sizeof(T))));
+    }
+}
+
+#endif // BINARY_IO_HPP
@@ -25,28 +25,17 @@ struct Turn {
     Direction direction;
 };
 
-struct TrafficLight {
-    enum State { RED, YELLOW, GREEN } state;
-
-    int redDuration;
-    int yellowDuration;
-    int greenDuration;
-    int timer;
-
-    void update();
-};
-
 /**
  * @class Cell
- * @brief Represents a single Cell in CA grid for traffic (velocity: -1=empty, >=0=car speed)
+ * @brief Static road layout of a single CA cell (road, spawn point, turn block, stop line).
+ *        Cars are per-step state and live in the Grid car buffers, lights are owned by the
+ *        Grid signal controller (a stop line only refers to its signal group).
  */
 class Cell {
 public:
     /** Constructor */
     Cell();
 
-    void moveCarTo(Cell& dest);
-
     /** Alive setter/getter */
     void setAlive(bool val) { alive = val; }
     bool isAlive() const { return alive; }
@@ -54,21 +43,6 @@ public:
     /** spawnPoint setter/getter */
     void setSpawnPoint(bool val) { spawnPoint = val; }
     bool isSpawnPoint() const { return spawnPoint; }
-    void spawnCar(int vmax, double willTurnProb, int id, Direction dir);
-    int getEffectiveVelocity() const;
-
-    /** Car setters/getters */
-    void setCar(const Car& c) { car = c; }
-    void setCarVelocity(int v);
-    void setCarId(int id);
-    void setCarDirection(Direction dir);
-    void setCarWillTurn(bool val);
-    Direction getCarDirection() const { return car ? car-> direction : Direction::RIGHT; }
-    int getCarVelocity() const { return car ? car->velocity : -1; }
-    int getCarId() const { return car ? car->id : -1; }
-    bool getCarWillTurn() const { return car ? car->willTurn : false; }
-    bool hasCar() const { return car.has_value(); }
-    void removeCar();
 
     /** Road setters/getters */
     void setTurn(const Turn& t);
@@ -77,22 +51,14 @@ public:
     Direction getTurnDirection() const { return turn ? turn->direction : Direction::RIGHT; }
     bool hasTurn() const { return turn.has_value(); }
 
-    /** TrafficLight setters/getters */
-    void setTrafficLight(const TrafficLight& t);
-    bool hasTrafficLight() const { return tl.has_value(); }
-    const std::optional<TrafficLight>& getTrafficLight() const { return tl; }
-    TrafficLight::State getTrafficLightState() const { return tl ? tl->state : TrafficLight::GREEN; }
-    void updateTrafficLight();
-
-    /** Cell setters/getters */
-    const long getTotalVelocity() const { return totalVelocity; }
-    void updateTotalVelocity();
+    /** Stop line setters/getters (signal group of the traffic light, -1 if none) */
+    void setSignalGroup(int group) { signalGroup = group; }
+    int getSignalGroup() const { return signalGroup; }
+    bool hasTrafficLight() const { return signalGroup >= 0; }
 
 private:
-    std::optional<Car> car;
     std::optional<Turn> turn;
-    std::optional<TrafficLight> tl;
-    long totalVelocity = 0;
+    int signalGroup = -1;
     bool spawnPoint = false;
     bool alive;
 };
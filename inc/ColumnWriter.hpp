@@ -0,0 +1,90 @@
+/**
+ * @file ColumnWriter.hpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#ifndef COLUMN_WRITER_HPP
+#define COLUMN_WRITER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @class ColumnWriter
+ * @brief Table written as one typed array per column (.col file), loadable with numpy.memmap without parsing.
+ *
+ * Layout (header values in the byte order given at offset 8, which is the writer's own):
+ *   0   char[8]   magic "TRAFCOL1"
+ *   8   char      byte order ('<' little, '>' big endian), 7 bytes padding
+ *   16  uint64    row count
+ *   24  uint32    column count, uint32 reserved
+ *   32  column count x { char[32] name, char[8] numpy dtype (e.g. "<i4", "|S5"), uint64 data offset }
+ * Column data follows, each array starting at a multiple of 64 bytes.
+ */
+class ColumnWriter {
+public:
+    /**
+     * @param rows Number of rows every column has
+     */
+    explicit ColumnWriter(uint64_t rows) : rows(rows) {}
+
+    /**
+     * @brief Adds a column of numbers (get(i) gives the value of row i)
+     */
+    template <class T, class Get>
+    void add(const std::string& name, Get get) {
+        static_assert(std::is_arithmetic_v<T>, "numeric columns only");
+        Column& column = addColumn(name, dtypeOf<T>(), sizeof(T));
+        for (uint64_t i = 0; i < rows; i++) {
+            T value = static_cast<T>(get(i));
+            std::memcpy(column.data.data() + i * sizeof(T), &value, sizeof(T));
+        }
+    }
+
+    /**
+     * @brief Adds a column of fixed-width byte strings (NUL-padded, longer strings are cut)
+     */
+    template <class Get>
+    void addText(const std::string& name, size_t width, Get get) {
+        Column& column = addColumn(name, "|S" + std::to_string(width), width);
+        for (uint64_t i = 0; i < rows; i++) {
+            std::string value = get(i);
+            std::memcpy(column.data.data() + i * width, value.data(), std::min(width, value.size()));
+        }
+    }
+
+    /**
+     * @brief Writes the file
+     * @return False if the file cannot be written
+     */
+    bool write(const std::string& filename) const;
+
+private:
+    struct Column {
+        std::string name;
+        std::string dtype;
+        std::vector<char> data;
+    };
+
+    /**
+     * @brief Byte order character of this machine
+     */
+    static char byteOrder();
+
+    template <class T>
+    static std::string dtypeOf() {
+        char kind = std::is_floating_point_v<T> ? 'f' : std::is_signed_v<T> ? 'i' : 'u';
+        char order = sizeof(T) == 1 ? '|' : byteOrder();
+        return std::string{order, kind} + std::to_string(sizeof(T));
+    }
+
+    Column& addColumn(const std::string& name, const std::string& dtype, size_t width);
+
+    uint64_t rows;
+    std::vector<Column> columns;
+};
+
+#endif // COLUMN_WRITER_HPP
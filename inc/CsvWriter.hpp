@@ -0,0 +1,95 @@
+/**
+ * @file CsvWriter.hpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#ifndef CSV_WRITER_HPP
+#define CSV_WRITER_HPP
+
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+/**
+ * @class CsvWriter
+ * @brief CSV file written by a background thread. Rows are formatted with std::to_chars into a
+ *        buffer; a full buffer is handed to the writer thread and the caller continues in a second
+ *        one, so memory stays at two buffers and the caller only waits if the disk falls behind.
+ */
+class CsvWriter {
+public:
+    /**
+     * @param capacity Buffer size that triggers a hand-off to the writer thread
+     */
+    explicit CsvWriter(size_t capacity = 1 << 20);
+
+    /** Destructor (closes the file) */
+    ~CsvWriter();
+
+    CsvWriter(const CsvWriter&) = delete;
+    CsvWriter& operator=(const CsvWriter&) = delete;
+
+    /**
+     * @brief Opens (truncates) a file and starts the writer thread
+     * @return False if the file cannot be opened
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Writes everything buffered, stops the writer thread and closes the file
+     * @return False if any write or closing the file failed (e.g. disk full)
+     */
+    bool close();
+
+    bool isOpen() const { return file != nullptr; }
+
+    /**
+     * @brief Appends a field (separated from the previous field of the row by a comma)
+     */
+    CsvWriter& field(int value);
+    CsvWriter& field(long long value);
+    CsvWriter& field(double value);     ///< Fixed notation with 4 decimals (as std::fixed, std::setprecision(4))
+    CsvWriter& field(std::string_view value);
+
+    /**
+     * @brief Appends raw text (headers)
+     */
+    CsvWriter& raw(std::string_view text);
+
+    /**
+     * @brief Ends the current row
+     */
+    void endRow();
+
+private:
+    /**
+     * @brief Separates a new field from the previous one
+     */
+    void separate();
+
+    /**
+     * @brief Waits until the writer thread is idle and hands it the current buffer
+     */
+    void handOff();
+
+    /**
+     * @brief Writer thread body
+     */
+    void writerLoop();
+
+    size_t capacity;
+    std::FILE* file = nullptr;
+    std::string current;        ///< Buffer filled by the caller
+    std::string pending;        ///< Buffer being written by the writer thread
+    bool rowStarted = false;
+    bool closing = false;
+    bool failed = false;        ///< Set by the writer thread once a write fails
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::thread writer;
+};
+
+#endif // CSV_WRITER_HPP
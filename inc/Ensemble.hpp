@@ -0,0 +1,81 @@
+/**
+ * @file Ensemble.hpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#ifndef ENSEMBLE_HPP
+#define ENSEMBLE_HPP
+
+#include "Logger.hpp"
+#include "Simulation.hpp"
+#include "Statistics.hpp"
+#include "ThreadPool.hpp"
+#include <string>
+#include <vector>
+
+/**
+ * @class Ensemble
+ * @brief Independent replicas of one configuration run in parallel (replica i uses seed base + i)
+ */
+class Ensemble {
+public:
+    /**
+     * @brief Constructor
+     * @param base Configuration shared by all replicas (its seed is the seed of replica 0)
+     * @param pool Pool the replicas run on
+     */
+    Ensemble(const SimulationConfig& base, ThreadPool& pool);
+
+    /**
+     * @brief Runs count more replicas
+     */
+    void addReplicas(int count);
+
+    /**
+     * @brief Adds replicas (one per pool thread at a time) until the 95% CI half-width of throughput,
+     *        time in system and max queue is at most target * |mean|, or maxReplicas are done
+     * @param target Relative CI half-width
+     * @param maxReplicas Upper limit on the number of replicas
+     * @return True if the target was reached
+     */
+    bool runUntil(double target, int maxReplicas);
+
+    /**
+     * @brief Gets KPIs of every replica in seed order
+     */
+    const std::vector<SummaryStatistics>& getReplicas() const { return replicas; }
+
+    /**
+     * @brief Gets delay distributions of all replicas pooled into one
+     */
+    DelaySketches mergedSketches() const;
+
+    /**
+     * @brief Gets estimate of a KPI by its summary_statistics.csv name
+     */
+    KpiEstimate estimate(const std::string& metric) const;
+
+    /**
+     * @brief Prints mean, stddev and 95% CI of every KPI
+     */
+    void printTable() const;
+
+    /**
+     * @brief Exports ensemble_statistics.csv (metric, mean, stddev, 95% CI, replicas),
+     *        replica_statistics.csv (one row of KPIs per replica) and delay_quantiles.csv
+     *        (pooled over replicas) to a directory
+     */
+    void exportAll(const std::string& directory) const;
+
+private:
+    /**
+     * @brief Checks if the tracked KPIs reached the relative CI target
+     */
+    bool converged(double target) const;
+
+    SimulationConfig base;
+    ThreadPool& pool;
+    std::vector<SummaryStatistics> replicas;
+    std::vector<DelaySketches> sketches;    ///< Delay distributions of every replica in seed order
+};
+
+#endif // ENSEMBLE_HPP
@@ -7,16 +7,47 @@
 #include "Cell.hpp"
 #include "Rules.hpp"
 #include "Logger.hpp"
+#include "LaneGraph.hpp"
+#include "Random.hpp"
+#include "SignalController.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <functional>
 #include <vector>
 #include <fstream>
+#include <istream>
+#include <ostream>
 #include <string>
 
-#include <vector>
 #include <tuple>
 
 class Logger;
 struct TimestepMetrics;
 
+/**
+ * @brief Entry of the vehicle table (car state and the cell it occupies)
+ */
+struct Vehicle {
+    Car car;
+    int lane = -1;          ///< Lane the car drives on
+    int pos = -1;           ///< Position on the lane
+    int leader = -1;        ///< Next vehicle ahead on the same lane (-1 if none)
+    int follower = -1;      ///< Next vehicle behind on the same lane (-1 if none)
+    int newVelocity = 0;    ///< Velocity planned for the step being computed (set when the car moves)
+    bool active = false;    ///< False if the slot is free
+};
+
+/**
+ * @brief Green durations of the signal groups (red durations follow from the phase order)
+ */
+struct SignalPlan {
+    int northGreen = 80;            ///< North inbound
+    int southGreen = 80;            ///< South inbound
+    int westGreen = 80;             ///< West inbound
+    int eastStraightGreen = 120;    ///< East inbound straight lanes
+    int eastTurnGreen = 60;         ///< East inbound left turn lane
+};
+
 /**
  * @class Grid
  * @brief Represents a CA grid for traffic (1D road if height=1)
@@ -34,12 +65,18 @@ public:
     void initializeMap(double density, bool opt);
     /**
      * @brief Updates the grid using specified rules (NS for traffic)
+     *        R = Rules calls the rules virtually, R = NSRules runs the SIMD kernel over each lane.
+     *        VMax > 0 fixes the max velocity at compile time (vmax is then ignored).
+     *        Logged = false compiles out all logger hooks (per-lane metric tallies, per-car logging).
+     *        Instantiated for <Rules, 0>, <NSRules, 0>, <NSRules, 3> and <NSRules, 5>, the NSRules ones
+     *        also without logging.
      * @param rules Rules to be applied
      * @param vmax Max velocity
      * @param p Braking probability
      * @param step Currect step number
      */
-    void update(const Rules& rules, double density, int vmax, double p, int step);
+    template <class R, int VMax = 0, bool Logged = true>
+    void update(const R& rules, double density, int vmax, double p, int step);
     /**
      * @brief Finds distance to next car ahead (toroidal)
      * @param x X coordinate
@@ -58,8 +95,32 @@ public:
      * @param x X coordinate
      * @return Cell at set coordinate
      */
-    Cell& getCell(int y, int x) { return cells[y][x]; }
-    const Cell& getCell(int y, int x) const { return cells[y][x]; }
+    Cell& getCell(int y, int x) { return cells[index(y, x)]; }
+    const Cell& getCell(int y, int x) const { return cells[index(y, x)]; }
+
+    /**
+     * @brief Gets car occupying cell at (y, x) in the current state
+     * @param y Y coordinate
+     * @param x X coordinate
+     * @return Car at set coordinate (nullptr if cell is free)
+     */
+    const Car* getCar(int y, int x) const {
+        int slot = lanes.occupantAt(x, y);
+        return slot < 0 ? nullptr : &vehicles[slot].car;
+    }
+    bool hasCar(int y, int x) const { return lanes.occupantAt(x, y) >= 0; }
+
+    /**
+     * @brief Gets the vehicle table (inactive slots are free)
+     * @return Vehicle table
+     */
+    const std::vector<Vehicle>& getVehicles() const { return vehicles; }
+
+    /**
+     * @brief Gets lanes compiled from the painted map
+     * @return Lane graph
+     */
+    const LaneGraph& getLanes() const { return lanes; }
     
     /**
      * @brief Gets the width of the grid
@@ -84,12 +145,76 @@ public:
      */
     int getMaxCars() const { return maxCars; }
 
+    /**
+     * @brief Sets seed of the random generator (all draws are keyed by seed, step and car/cell)
+     * @param seed Seed
+     */
+    void setSeed(uint64_t seed) { rng.setSeed(seed); }
+    uint64_t getSeed() const { return rng.getSeed(); }
+
+    /**
+     * @brief Sets green durations of the signal groups (call before setupCrossroadLights)
+     * @param plan Signal plan
+     */
+    void setSignalPlan(const SignalPlan& plan);
+    SignalPlan getSignalPlan() const;
+
+    /**
+     * @brief Gets the controller owning the lights of all signal groups
+     */
+    const SignalController& getSignals() const { return signals; }
+
+    /**
+     * @brief Gets light shown at a stop line cell (GREEN if the cell has no traffic light)
+     */
+    SignalState getSignalState(const Cell& cell) const {
+        return cell.hasTrafficLight() ? signals.getState(cell.getSignalGroup()) : SignalState::GREEN;
+    }
+
+    /**
+     * @brief Scales spawn probabilities of all approaches (inflow, capped at 1)
+     * @param scale Factor (1 = default demand)
+     */
+    void setInflowScale(double scale) { inflowScale = scale; }
+    double getInflowScale() const { return inflowScale; }
+
+    /**
+     * @brief Gets number of cells cars can drive on (cells covered by lanes)
+     */
+    int getRoadCells() const { return roadCells; }
+
+    /**
+     * @brief Sets thread pool used to update lanes in parallel (results do not depend on thread count)
+     * @param p Pointer to thread pool (nullptr to update on the calling thread)
+     */
+    void setThreadPool(ThreadPool* p) { pool = p; }
+
+    /**
+     * @brief Writes dynamic state to a checkpoint (vehicle table, lane order, counters, seed, signal step)
+     * @param out Binary output stream
+     */
+    void save(std::ostream& out) const;
+
+    /**
+     * @brief Restores state written by save() (the grid must be built with the same layout,
+     *        density and signal plan may differ)
+     * @param in Binary input stream
+     * @return False if the data is damaged or does not fit this layout
+     */
+    bool load(std::istream& in);
+
     /**
      * @brief Gets the next unique car ID and increments the internal counter
      * @return Next car ID
      */
     int getNextCarId() { return nextCarId++; }
 
+    /**
+     * @brief Gets number of cars spawned so far and number of cars on the grid (kept without a logger too)
+     */
+    int getCarsEntered() const { return nextCarId; }
+    int getCarsInSystem() const { return currentCars; }
+
     /**
      * @brief Determines if a car spawned at (x, y) will turn at the next turn block
      * @param x X coordinate
@@ -121,17 +246,21 @@ public:
      * @brief Set logger for data collection
      * @param l Pointer to logger instance
      */
-    void setLogger(Logger* l) { logger = l; }
+    void setLogger(Logger* l) {
+        logger = l;
+        if (logger)
+            logger->setSpatialSize(width, height);
+    }
     
     /**
-     * @brief Collect metrics for current timestep
+     * @brief Collect metrics for current timestep from the per-lane tallies of the last logged update
      * @param currentStep Current simulation step
      * @return TimestepMetrics structure
      */
     TimestepMetrics collectTimestepMetrics(int currentStep);
     
     /**
-     * @brief Calculate maximum queue length for given direction
+     * @brief Calculate maximum queue length for given direction (scans the cars, independent of the tallies)
      * @param dir Direction to analyze
      * @return Maximum consecutive stopped vehicles
      */
@@ -144,22 +273,175 @@ public:
     void logDirectionMetrics(int currentStep);
 
 private:
+    /**
+     * @brief Per-lane arrays the NaSch kernel runs on (cars in lane order, gaps capped at vmax + 1,
+     *        sized to the lane length so a lane never reallocates)
+     */
+    struct VelocityBatch {
+        std::vector<int16_t> vel;       ///< Current velocity on input, planned velocity on output
+        std::vector<int16_t> gap;
+        std::vector<int16_t> brake;
+    };
+
+    /**
+     * @brief Per-lane metrics of the step being applied, counted as cars take their final cells
+     *        (queues are runs of stopped cars on adjacent positions, fed front to back)
+     */
+    struct LaneTally {
+        int velocitySum = 0;
+        int cars = 0;
+        int stopped = 0;
+        int atRed = 0;          ///< Cars on a stop line showing red
+        int maxQueue = 0;
+        int run = 0;            ///< Length of the queue ending at runEnd
+        int runEnd = -2;        ///< Position of the last queued car fed
+        bool stale = false;     ///< Queues changed out of lane order (recounted after the moves)
+
+        void add(const Lane& lane, int pos, int velocity, int sign = 1) {
+            velocitySum += sign * velocity;
+            cars += sign;
+            stopped += sign * (velocity == 0);
+            atRed += sign * lane.isRed(pos);
+        }
+
+        void queue(int pos) {
+            run = pos == runEnd - 1 ? run + 1 : 1;
+            runEnd = pos;
+            maxQueue = std::max(maxQueue, run);
+        }
+    };
+
+    /**
+     * @brief Flat index of cell (y, x) in row-major buffers
+     */
+    int index(int y, int x) const { return y * width + x; }
+
+    /**
+     * @brief Rebuilds spawn point and stop line lists and compiles lanes after the map changes
+     */
+    void compileLayout();
+
+    /**
+     * @brief Writes the lights of all signal groups into the lane red masks
+     */
+    void applySignals();
+
+    /**
+     * @brief Finds distance to the next obstacle ahead of a vehicle on its lane in O(1)
+     *        (leader link, precomputed stop line/turn distances, occupied crossing cells)
+     * @param vehicle Vehicle on a lane
+     * @param limit Distances above limit are reported as limit
+     * @return Distance (cells) to next car, red light or turn block
+     */
+    int gapAhead(const Vehicle& vehicle, int limit) const;
+
+    /**
+     * @brief Runs fn(lane) for every lane, in parallel if a thread pool is set
+     */
+    void forEachLane(const std::function<void(int)>& fn);
+
+    /**
+     * @brief Plans new velocities of all cars on a lane into batches[l] (reads the lanes only)
+     * @param l Lane index
+     * @param rules Rules to be applied
+     * @param vmax Max velocity (replaced by VMax if VMax > 0)
+     * @param p Braking probability
+     * @param step Current step number
+     */
+    template <class R, int VMax>
+    void planLane(int l, const R& rules, int vmax, double p, int step);
+
+    /**
+     * @brief Sizes the kernel arrays of every lane to the lane length
+     */
+    void allocateBatches();
+
+    /**
+     * @brief Moves cars by their planned velocities, spawns new cars and logs the step (if Logged)
+     * @param vmax Max velocity of spawned cars
+     * @param step Current step number
+     */
+    template <bool Logged>
+    void applyMoves(int vmax, int step);
+
+    /**
+     * @brief Moves cars that stay on lane l outside of crossing cells (touches lane l only),
+     *        remaining cars are collected in deferredMoves[l] for the serial pass
+     *        (Logged also restarts laneTallies[l], counting moved cars and queues of stopped cars)
+     * @param l Lane index
+     */
+    template <bool Logged>
+    void moveLane(int l);
+
+    /**
+     * @brief Recounts queues of lanes whose tally went stale by walking their cars
+     */
+    void recountStaleQueues();
+
+    /**
+     * @brief Gets flat grid index of the cell a vehicle occupies
+     */
+    int cellOf(const Vehicle& vehicle) const { return lanes.getLane(vehicle.lane).cell[vehicle.pos]; }
+
+    /**
+     * @brief Creates a new car with random initial velocity and turn intention
+     * @param vmax Max velocity
+     * @param willTurnProb Probability that the car will turn
+     * @param id Car ID
+     * @param dir Initial direction
+     * @param step Current step (random draws are keyed by step and ID)
+     * @return Created car
+     */
+    Car createCar(int vmax, double willTurnProb, int id, Direction dir, int step) const;
+
+    /**
+     * @brief Puts a car into a free slot of the vehicle table
+     * @param car Car to add
+     * @param at Occupied lane position
+     * @return Slot of the added vehicle
+     */
+    int addVehicle(const Car& car, LanePos at);
+
+    /**
+     * @brief Frees a slot of the vehicle table and unlinks it from its lane (occupancy is left to the caller)
+     * @param slot Slot to free
+     */
+    void removeVehicle(int slot);
+
+    /**
+     * @brief Inserts a vehicle into the ordered car list of its lane
+     * @param slot Vehicle slot
+     */
+    void linkVehicle(int slot);
+
+    /**
+     * @brief Removes a vehicle from the ordered car list of its lane
+     * @param slot Vehicle slot
+     */
+    void unlinkVehicle(int slot);
+
     int width;                              ///< Width of the grid
     int height;                             ///< Height of the grid
-    std::vector<std::vector<Cell>> cells;   ///< 2D vector containing cells
+    std::vector<Cell> cells;                ///< Static road layout (row-major), not rewritten per step
+    std::vector<Vehicle> vehicles;          ///< Vehicle table maintained on spawn, move and exit
+    std::vector<int> freeSlots;             ///< Free slots of the vehicle table
+    LaneGraph lanes;                        ///< Lanes the cars drive on (2D cars are only rebuilt for export)
+    CounterRng rng;                         ///< Counter-based generator for all random decisions
+    std::vector<int> spawnCells;            ///< Indices of spawn point cells (row-major order)
+    SignalController signals;               ///< Phase plan and lights of all signal groups
+    std::vector<std::vector<int>> groupCells;   ///< Per signal group, indices of its stop line cells
+    std::vector<std::vector<int>> deferredMoves;  ///< Per lane, cars moved in the serial pass (front to back)
+    std::vector<VelocityBatch> batches;     ///< Per lane, kernel input of the current step
+    std::vector<LaneTally> laneTallies;     ///< Per lane, metrics of the last logged step
+    ThreadPool* pool = nullptr;             ///< Pool for per-lane passes (nullptr for single thread)
     int nextCarId = 0;                      ///< ID of the next car
 
-    // Traffic light durations (yellow is calculated from green -> 90% green / 10% yellow) (red is calculated in setupCrossroadLights)
+    // Green durations of the signal groups (yellow is calculated from green -> 90% green / 10% yellow) (phase starts and the cycle are calculated in setupCrossroadLights)
     int northInGreenDuration = 80;           ///< Green light duration for north inbound
-    int northInRedDuration = 0;              ///< Red light duration for north inbound
     int southInGreenDuration = 80;           ///< Green light duration for south inbound
-    int southInRedDuration = 0;              ///< Red light duration for south inbound
     int westInGreenDuration = 80;            ///< Green light duration for west inbound (should be eastInStraightGreenDuration - eastInTurnGreenDuration)
-    int westInRedDuration = 0;               ///< Red light duration for west inbound
     int eastInStraightGreenDuration = 120;   ///< Green light duration for east inbound (straight)
-    int eastInStraightRedDuration = 0;       ///< Red light duration for east inbound (straight)
     int eastInTurnGreenDuration = 60;        ///< Green light duration for east inbound (left turn)
-    int eastInTurnRedDuration = 0;           ///< Red light duration for east inbound (left turn)
 
     int numLanesNorthIn = 3;  ///< From NORTH to SOUTH (towards junction)
     int numLanesNorthOut = 2; ///< From SOUTH to NORTH (away from junction)
@@ -194,6 +476,8 @@ private:
     double eastSpawnProb = 0.645;       ///< Probability  of spawning a car in the east
 
     double willTurnProb = 0.4; ///< Probability that a car will turn at the next turn block
+    double inflowScale = 1.0;  ///< Factor applied to all spawn probabilities
+    int roadCells = 0;         ///< Cells covered by lanes
 
     bool normalize = false; ///< If --optimize is set then this becomes 1 to shift all affected areas
 
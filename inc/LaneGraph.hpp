@@ -0,0 +1,181 @@
+/**
+ * @file LaneGraph.hpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#ifndef LANE_GRAPH_HPP
+#define LANE_GRAPH_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Cell.hpp"
+
+/**
+ * @brief Position on a lane (lane is -1 if the cell is not on any lane)
+ */
+struct LanePos {
+    int lane = -1;
+    int pos = -1;
+
+    bool valid() const { return lane >= 0; }
+};
+
+/**
+ * @brief Link from a turn cell into the lane a turning car continues on
+ */
+struct LaneLink {
+    int pos;        ///< Position of the turn cell on the source lane
+    LanePos to;     ///< The same cell on the target lane
+};
+
+/**
+ * @brief Contiguous 1D lane running in one direction from its first entry cell to the grid edge
+ */
+struct Lane {
+    /** Static per-position flags */
+    enum Flag : uint8_t {
+        STOP_LINE = 1 << 0,     ///< Cell has a traffic light
+        TURN      = 1 << 1,     ///< Cell has a turn block
+        SHARED    = 1 << 2      ///< Cell is also part of a crossing lane
+    };
+
+    static constexpr int NONE = 1 << 29;   ///< Distance used when no static obstacle is ahead
+
+    Direction dir;                  ///< Direction of travel
+    int line;                       ///< Row (horizontal lanes) or column (vertical lanes)
+    int offset;                     ///< Distance of the first cell from the edge cars drive away from
+    int length;                     ///< Number of cells up to the grid edge
+    int clearDistance;              ///< Distance reported when the road ahead is free (grid width or height)
+    std::vector<int> cell;          ///< Flat grid index of each position
+    std::vector<uint8_t> flags;     ///< Static flags of each position
+    std::vector<int> nextTurn;      ///< Distance to the next turn block ahead of each position (NONE if none)
+    std::vector<int> occupant;      ///< Vehicle slot in each position, cars of crossing lanes included (-1 if free)
+    std::vector<uint64_t> occupiedBits; ///< Bitboard of occupied positions (bit p % 64 of word p / 64)
+    std::vector<uint64_t> redBits;  ///< Bitboard of stop lines currently showing red
+    std::vector<LaneLink> links;    ///< Turn links ordered by position
+    int front = -1;                 ///< First vehicle driving on the lane (followers are linked from it)
+    int back = -1;                  ///< Last vehicle driving on the lane
+
+    /**
+     * @brief Sets vehicle slot of a position on this lane only, keeping the bitboard in sync
+     * @param pos Position
+     * @param slot Vehicle slot (-1 to clear)
+     */
+    void place(int pos, int slot) {
+        occupant[pos] = slot;
+        uint64_t bit = uint64_t{1} << (pos & 63);
+        occupiedBits[pos >> 6] = slot >= 0 ? occupiedBits[pos >> 6] | bit : occupiedBits[pos >> 6] & ~bit;
+    }
+
+    /**
+     * @brief Marks stop line at a position as red or not
+     */
+    void setRed(int pos, bool red) {
+        uint64_t bit = uint64_t{1} << (pos & 63);
+        redBits[pos >> 6] = red ? redBits[pos >> 6] | bit : redBits[pos >> 6] & ~bit;
+    }
+
+    /**
+     * @brief Checks if a position is a stop line currently showing red
+     */
+    bool isRed(int pos) const { return (redBits[pos >> 6] >> (pos & 63)) & 1; }
+
+    /**
+     * @brief Finds the first occupied cell or red stop line ahead of a position, 64 cells at a time
+     * @param pos Position to search from (exclusive)
+     * @param limit Distances of limit and more are not searched
+     * @return Distance to the blocked cell (limit if none is closer)
+     */
+    int firstBlocked(int pos, int limit) const {
+        int from = pos + 1;
+        int end = std::min(pos + limit, length);
+        if (from >= end)
+            return limit;
+
+        int word = from >> 6;
+        uint64_t bits = (occupiedBits[word] | redBits[word]) & (~uint64_t{0} << (from & 63));
+        while (!bits) {
+            if (++word << 6 >= end)
+                return limit;
+            bits = occupiedBits[word] | redBits[word];
+        }
+
+        int blocked = (word << 6) + __builtin_ctzll(bits);
+        return blocked < end ? blocked - pos : limit;
+    }
+};
+
+/**
+ * @class LaneGraph
+ * @brief Painted intersection compiled into 1D lanes connected by turn links
+ */
+class LaneGraph {
+public:
+    /**
+     * @brief Builds lanes from the painted map (drops all occupants)
+     * @param cells Static road layout (row-major)
+     * @param width Grid width
+     * @param height Grid height
+     * @param entries Spawn cells (flat index) and the direction cars enter with
+     */
+    void compile(const std::vector<Cell>& cells, int width, int height,
+                 const std::vector<std::pair<int, Direction>>& entries);
+
+    /**
+     * @brief Finds the lane position of cell (x, y) for cars driving in given direction
+     * @return Lane position (invalid if no lane runs there)
+     */
+    LanePos locate(int x, int y, Direction dir) const;
+
+    /**
+     * @brief Finds turn link at given lane position
+     * @return Link or nullptr if turning keeps the car on its lane
+     */
+    const LaneLink* findLink(int lane, int pos) const;
+
+    /**
+     * @brief Sets vehicle slot occupying a lane position and all lanes crossing the same cell
+     * @param at Lane position
+     * @param slot Vehicle slot (-1 to clear)
+     */
+    void setOccupant(LanePos at, int slot);
+
+    /**
+     * @brief Marks stop lines of all lanes running through a cell as red or not
+     * @param cell Flat grid index of a traffic light cell
+     * @param red True if the light shows red
+     */
+    void setRed(int cell, bool red);
+
+    /**
+     * @brief Gets vehicle slot occupying a lane position (-1 if free)
+     */
+    int getOccupant(LanePos at) const { return lanes[at.lane].occupant[at.pos]; }
+
+    /**
+     * @brief Gets vehicle slot occupying cell (x, y) on any lane (-1 if free)
+     */
+    int occupantAt(int x, int y) const;
+
+    /**
+     * @brief Gets lanes
+     */
+    const std::vector<Lane>& getLanes() const { return lanes; }
+    const Lane& getLane(int lane) const { return lanes[lane]; }
+    Lane& getLane(int lane) { return lanes[lane]; }
+
+private:
+    /**
+     * @brief Distance of (x, y) from the edge cars driving in dir come from
+     */
+    int progress(int x, int y, Direction dir) const;
+
+    int width = 0;
+    int height = 0;
+    std::vector<Lane> lanes;
+    std::array<std::vector<int>, 4> laneByLine;    ///< Lane of each row/column per direction (-1 if none)
+};
+
+#endif // LANE_GRAPH_HPP
@@ -6,11 +6,19 @@
 #ifndef LOGGER_HPP
 #define LOGGER_HPP
 
+#include <array>
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <map>
-#include <unordered_map>
+#include <algorithm>
+#include <istream>
+#include <memory>
+#include <ostream>
 #include "Cell.hpp"
+#include "CsvWriter.hpp"
+#include "PathRecorder.hpp"
+#include "QuantileSketch.hpp"
 
 /**
  * @brief Per-timestep aggregate metrics for the entire intersection
@@ -62,13 +70,40 @@ struct VehicleTrajectory {
 };
 
 /**
- * @brief Spatial heatmap data for congestion visualization
+ * @brief Totals of the vehicles of one approach (vehicles still on the grid only count in vehicles)
+ */
+struct VehicleTotals {
+    int vehicles = 0;           // Vehicles spawned on this approach
+    int exited = 0;             // Vehicles that crossed the grid
+    int sampledExited = 0;      // Exited vehicles in the vehicle sample (the sums are over these)
+    double velocitySum = 0.0;   // Sum of avgVelocity of sampled exited vehicles
+    long long stoppedSum = 0;   // Sum of stepsAtZeroVelocity of sampled exited vehicles
+};
+
+/**
+ * @brief Spatial heatmap accumulator of one cell for congestion visualization
+ *        (cell position follows from its index, average velocity is computed on export)
  */
 struct SpatialData {
-    int x, y;
-    long long totalVelocity;    // Sum of all velocities at this cell
-    int observations;           // Number of times a car was here
-    double avgVelocity;         // Computed: totalVelocity / observations
+    long long totalVelocity = 0;    // Sum of all velocities at this cell
+    int observations = 0;           // Number of times a car was here
+};
+
+/**
+ * @brief Rectangle of heatmap cells (corners included)
+ */
+struct SpatialRegion {
+    int x0, y0;
+    int x1, y1;
+};
+
+/**
+ * @brief What the logger records (default: every step, every vehicle, the whole grid)
+ */
+struct LogSampling {
+    int stride = 1;                     // Timestep rows and heatmap observations of every stride-th step
+    double vehicleRate = 1.0;           // Fraction of spawned vehicles tracked for their whole life (by ID hash)
+    std::vector<SpatialRegion> regions; // Heatmap cells observed (empty = whole grid)
 };
 
 /**
@@ -84,6 +119,41 @@ struct DirectionMetrics {
     double throughputRate;      // Vehicles per minute
 };
 
+/**
+ * @brief Key performance indicators of a whole run (rows of summary_statistics.csv)
+ */
+struct SummaryStatistics {
+    int warmupSteps = 0;                // Leading steps left out of all other KPIs
+    int totalSteps = 0;
+    int totalCarsSpawned = 0;
+    int totalCarsExited = 0;
+    double completionRate = 0.0;        // Exited / spawned
+    double avgVelocity = 0.0;           // Mean over timesteps
+    double avgStoppedCars = 0.0;        // Mean over timesteps
+    double avgCarsInSystem = 0.0;       // Mean over timesteps
+    int maxQueueLength = 0;             // Longest queue over all timesteps and approaches
+    double avgTimeInSystem = 0.0;       // Mean over exited vehicles
+    double avgWaitingTime = 0.0;        // Mean over exited vehicles
+    double timeInSystemP50 = 0.0;       // Quantiles over exited vehicles (DelaySketches)
+    double timeInSystemP95 = 0.0;
+    double timeInSystemP99 = 0.0;
+    double waitingTimeP50 = 0.0;
+    double waitingTimeP95 = 0.0;
+    double waitingTimeP99 = 0.0;
+    double throughputPerMinute = 0.0;   // Exited vehicles per 60 steps
+};
+
+/**
+ * @brief Distributions over exited vehicles, kept in constant memory and mergeable across replicas
+ */
+struct DelaySketches {
+    QuantileSketch timeInSystem;                    // Steps from spawn to exit
+    QuantileSketch waitingTime;                     // Steps at zero velocity
+    std::array<QuantileSketch, 4> approachWaiting;  // Steps at zero velocity by spawn Direction
+
+    void merge(const DelaySketches& other);
+};
+
 /**
  * @class Logger
  * @brief Collects and exports comprehensive traffic simulation data
@@ -93,29 +163,100 @@ public:
     Logger() = default;
 
     /**
-     * @brief Record metrics for current timestep
+     * @brief Record metrics for current timestep (steps have to come in order, only every stride-th step
+     *        is kept, streamed and included in the per-step averages of the summary)
      */
     void logTimestep(const TimestepMetrics& metrics);
-    
+
+    /**
+     * @brief Sets the timestep stride, vehicle sample rate and heatmap regions (before the run)
+     */
+    void setSampling(const LogSampling& s);
+    const LogSampling& getSampling() const { return sampling; }
+
+    /**
+     * @brief Checks if heatmap observations of given step are recorded
+     */
+    bool isSpatialStep(int step) const { return step % sampling.stride == 0; }
+
+    /**
+     * @brief Checks if the vehicle in given slot is tracked (spawned and in the sample)
+     */
+    bool isTracked(int slot) const {
+        return slot < static_cast<int>(vehicleData.size()) && vehicleData[slot].vehicleId >= 0;
+    }
+
     /**
-     * @brief Record vehicle entering the system
+     * @brief Checks if any vehicle can be tracked (vehicle sample rate above 0)
      */
-    void logVehicleSpawn(int vehicleId, int step, Direction spawnDir, bool willTurn);
+    bool tracksVehicles() const { return sampling.vehicleRate > 0.0; }
     
     /**
-     * @brief Record vehicle exiting the system
+     * @brief Record vehicle entering the system (vehicles outside the sample are only counted)
+     * @param slot Vehicle-table slot the vehicle occupies until it leaves
      */
-    void logVehicleExit(int vehicleId, int step);
+    void logVehicleSpawn(int slot, int vehicleId, int step, Direction spawnDir, bool willTurn);
     
     /**
-     * @brief Update vehicle statistics during simulation
+     * @brief Record vehicle in given slot exiting the system
      */
-    void logVehicleState(int vehicleId, int step, int x, int y, int velocity);
+    void logVehicleExit(int slot, int step);
+
+    /**
+     * @brief Record vehicle in given slot being removed without exiting (lost in a merge)
+     */
+    void logVehicleLost(int slot, int step);
     
     /**
-     * @brief Record spatial data for heatmap generation
+     * @brief Update statistics (and the recorded path) of the vehicle in given slot during simulation
+     */
+    void logVehicleState(int slot, int step, int x, int y, int velocity) {
+        if (slot >= static_cast<int>(vehicleData.size()) || vehicleData[slot].vehicleId < 0)
+            return;
+        VehicleTrajectory& traj = vehicleData[slot];
+        if (paths)
+            paths->record(slot, x, y);
+
+        if (velocity == 0)
+            traj.stepsAtZeroVelocity++;
+        traj.totalDistance += velocity;
+        traj.maxVelocity = std::max(traj.maxVelocity, velocity);
+
+        // Update average velocity (incremental)
+        int currentSteps = step - traj.spawnStep + 1;
+        traj.avgVelocity = ((traj.avgVelocity * (currentSteps - 1)) + velocity) / currentSteps;
+    }
+
+    /**
+     * @brief Keep the record of every vehicle that left the grid (needed only for exportVehicleTrajectories,
+     *        without records memory does not grow with the number of spawned vehicles)
      */
-    void logSpatialData(int x, int y, int velocity);
+    void setKeepVehicleRecords(bool keep) { keepVehicleRecords = keep; }
+
+    /**
+     * @brief Gets totals of all vehicles spawned on given approach
+     */
+    VehicleTotals getVehicleTotals(Direction dir) const;
+
+    /**
+     * @brief Size the heatmap to the grid (drops collected spatial data)
+     * @param width Grid width
+     * @param height Grid height
+     */
+    void setSpatialSize(int width, int height);
+
+    /**
+     * @brief Record spatial data for heatmap generation ((x, y) must lie in the size set by setSpatialSize,
+     *        cells outside the sampling regions are skipped)
+     */
+    void logSpatialData(int x, int y, int velocity) {
+        size_t i = static_cast<size_t>(y) * spatialWidth + x;
+        if (!spatialMask.empty() && !spatialMask[i])
+            return;
+        SpatialData& data = spatialData[i];
+        data.totalVelocity += velocity;
+        data.observations++;
+    }
     
     /**
      * @brief Record direction-specific metrics
@@ -138,6 +279,18 @@ public:
      */
     void exportVehicleTrajectories(const std::string& filename) const;
     
+    /**
+     * @brief Export timestep metrics / vehicle trajectories as a columnar binary file (ColumnWriter),
+     *        same columns as the CSV (spawnDirection as 5-byte text)
+     */
+    void exportTimestepColumns(const std::string& filename) const;
+    void exportTrajectoryColumns(const std::string& filename) const;
+
+    /**
+     * @brief Make exportAll write timestep metrics and trajectories as .col instead of .csv files
+     */
+    void setColumnarExport(bool columnar) { columnarExport = columnar; }
+
     /**
      * @brief Export spatial heatmap data to CSV
      * Columns: x, y, totalVelocity, observations, avgVelocity
@@ -156,18 +309,87 @@ public:
      * Single row with key performance indicators (KPIs)
      */
     void exportSummaryStatistics(const std::string& filename) const;
+
+    /**
+     * @brief Export quantiles of delay sketches to CSV (own ones, or merged ones of replicas)
+     * Columns: metric, approach, vehicles, mean, p50, p90, p95, p99, max
+     */
+    static void exportDelayQuantiles(const DelaySketches& sketches, const std::string& filename);
+
+    /**
+     * @brief Gets distributions of exited vehicles (sampled vehicles spawned after the current warm-up)
+     */
+    const DelaySketches& getDelaySketches() const { return sketches; }
+    
+    /**
+     * @brief Leave the first steps of the run out of the summary (warm-up truncation)
+     * @param steps Steps to leave out (0 = whole run)
+     */
+    void setWarmup(int steps);
+    int getWarmup() const { return warmupSteps; }
+
+    /**
+     * @brief Compute key performance indicators of the logged run (after the warm-up),
+     *        from running totals so it does not walk the logged data
+     */
+    SummaryStatistics computeSummary() const;
     
     /**
-     * @brief Export all data files to specified directory
+     * @brief Export all data files to specified directory (files written by streaming are skipped)
      */
     void exportAll(const std::string& directory) const;
 
     /**
-     * @brief Finalize vehicle trajectories (compute averages, etc.)
+     * @brief Write timestep rows and trajectories of vehicles leaving the grid to timestep_metrics.csv and
+     *        vehicle_trajectories.csv in given directory while the simulation runs (in a background thread)
+     * @return False if a file cannot be opened
+     */
+    bool startStreaming(const std::string& directory);
+
+    /**
+     * @brief Writes trajectories of vehicles still on the grid and closes the streamed files
+     * @return False if a streamed file could not be written completely
+     */
+    bool stopStreaming();
+
+    /**
+     * @brief Record the position of every spawned vehicle at every step into a path file (PathRecorder)
+     * @return False if the file cannot be created
+     */
+    bool startPaths(const std::string& filename);
+
+    /**
+     * @brief Writes paths of vehicles still on the grid and closes the path file
+     * @return Bytes written (0 if no paths were recorded)
+     */
+    uint64_t stopPaths();
+
+    /**
+     * @brief Keep every logged step in timestepData (needed by warm-up truncation and checkpoints;
+     *        without it memory does not grow with the number of steps)
+     */
+    void setKeepTimesteps(bool keep) { keepTimesteps = keep; }
+
+    const TimestepMetrics& getLastTimestep() const { return lastTimestep; }
+    size_t getLoggedSteps() const { return loggedSteps; }
+
+    /**
+     * @brief Finalize trajectories of vehicles still on the grid (time in system up to the last step)
      * Call this after simulation completes
      */
     void finalizeData();
     
+    /**
+     * @brief Write all collected data to a checkpoint
+     */
+    void save(std::ostream& out) const;
+
+    /**
+     * @brief Replace collected data with data written by save()
+     * @return False if the data is damaged
+     */
+    bool load(std::istream& in);
+
     /**
      * @brief Clear all collected data
      */
@@ -179,13 +401,121 @@ public:
     void printSummaryTable() const;
 
     // Data storage
-    std::vector<TimestepMetrics> timestepData;
-    std::unordered_map<int, VehicleTrajectory> vehicleData;
-    std::map<std::pair<int,int>, SpatialData> spatialData;
+    std::vector<TimestepMetrics> timestepData;        // Every logged step (if timesteps are kept)
+    std::vector<VehicleTrajectory> vehicleData;       // Vehicles on the grid by slot (vehicleId -1 = not tracked,
+                                                      // -2 = outside the vehicle sample, only counted)
+    std::vector<VehicleTrajectory> finishedVehicles;  // Vehicles that left the grid (if records are kept)
+    std::vector<SpatialData> spatialData;   // Row-major heatmap (spatialWidth cells per row)
     std::map<Direction, DirectionMetrics> directionData;
     
-    std::string directionToString(Direction dir) const;
+    static std::string directionToString(Direction dir);
 private:
+    /**
+     * @brief Totals of the exited vehicles spawned in one step
+     */
+    struct SpawnCohort {
+        int exited = 0;
+        long long timeInSystem = 0;
+        long long stopped = 0;
+    };
+
+    /**
+     * @brief Delays of one exited vehicle, kept by spawn step so the sketches can follow the warm-up
+     */
+    struct ExitDelay {
+        int timeInSystem;
+        int waitingTime;
+        Direction dir;
+    };
+
+    /**
+     * @brief Sums of per-step metrics over a range of logged steps
+     */
+    struct StepTotals {
+        int steps = 0;
+        double velocity = 0.0;
+        long long stopped = 0;
+        long long carsInSystem = 0;
+    };
+
+    static constexpr int UNTRACKED = -1;    ///< vehicleId of a free slot or a vehicle that was never spawned
+    static constexpr int UNSAMPLED = -2;    ///< vehicleId of a vehicle outside the sample
+
+    /**
+     * @brief Keeps a recorded step (stream, step history, running totals)
+     */
+    void recordTimestep(const TimestepMetrics& metrics);
+
+    /**
+     * @brief Checks if a vehicle belongs to the sample (hash of its ID below the sample rate)
+     */
+    bool isSampled(int vehicleId) const;
+
+    /**
+     * @brief Marks heatmap cells covered by the sampling regions (no mask without regions)
+     */
+    void buildSpatialMask();
+
+    /**
+     * @brief Folds the vehicle in given slot into the totals and frees the slot
+     */
+    void finishVehicle(int slot);
+
+    /**
+     * @brief Adds (sign 1) or removes (sign -1) a logged step or an exited cohort to/from totals
+     */
+    static void accumulate(StepTotals& totals, const TimestepMetrics& metrics, int sign);
+    static void accumulate(SpawnCohort& totals, const SpawnCohort& cohort, int sign);
+
+    /**
+     * @brief Adds (sign 1) or removes (sign -1) the exited vehicles spawned in given step to/from the sketches
+     */
+    void sketchCohort(int spawn, int sign);
+
+    /**
+     * @brief Longest queue of any approach in a logged step
+     */
+    static int maxQueueOf(const TimestepMetrics& metrics);
+
+    /**
+     * @brief Recomputes all running totals from the logged data (after load)
+     */
+    void rebuildTotals();
+
+    /**
+     * @brief Rows of timestep_metrics.csv and vehicle_trajectories.csv (streamed and exported alike)
+     */
+    static void writeTimestepHeader(CsvWriter& out);
+    static void writeTimestepRow(CsvWriter& out, const TimestepMetrics& metrics);
+    static void writeTrajectoryHeader(CsvWriter& out);
+    void writeTrajectoryRow(CsvWriter& out, const VehicleTrajectory& traj) const;
+
+    int warmupSteps = 0;    ///< Steps left out of the summary
+    int spatialWidth = 0;   ///< Row length of spatialData
+    LogSampling sampling;
+    std::vector<uint8_t> spatialMask;   ///< Heatmap cells inside the sampling regions (empty = all)
+    bool keepVehicleRecords = true;
+    bool keepTimesteps = true;
+    TimestepMetrics lastTimestep{};
+    size_t loggedSteps = 0;
+    std::unique_ptr<CsvWriter> timestepStream;      ///< Open while streaming
+    std::unique_ptr<CsvWriter> trajectoryStream;
+    std::string streamDirectory;
+    bool streamed = false;                          ///< Timesteps and trajectories were streamed, exportAll skips them
+    bool columnarExport = false;
+    std::unique_ptr<PathRecorder> paths;            ///< Open while recording paths
+    std::vector<SpawnCohort> cohorts;               ///< Exited vehicles by spawn step
+    // Running totals, the summary is the whole run minus the warm-up part
+    StepTotals stepTotals;              ///< All logged steps
+    StepTotals warmupStepTotals;        ///< Logged steps before warmupSteps
+    size_t warmupIndex = 0;             ///< Number of logged steps before warmupSteps
+    SpawnCohort exitedTotals;           ///< All exited vehicles
+    SpawnCohort warmupExitedTotals;     ///< Exited vehicles spawned before warmupSteps
+    std::vector<size_t> queuePeaks;     ///< Kept steps with a longer queue than every later step (max of any suffix)
+    int maxQueue = 0;                   ///< Longest queue of all logged steps
+    std::vector<VehicleTotals> finishedTotals = std::vector<VehicleTotals>(4); ///< Vehicles that left the grid by Direction
+    std::vector<std::vector<ExitDelay>> cohortDelays;  ///< Delays of exited vehicles by spawn step
+    DelaySketches sketches;             ///< Distributions of exited vehicles spawned after the warm-up
 };
 
 #endif // LOGGER_HPP
\ No newline at end of file
@@ -0,0 +1,66 @@
+/**
+ * @file NaschKernel.hpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#ifndef NASCH_KERNEL_HPP
+#define NASCH_KERNEL_HPP
+
+#include <cstdint>
+
+/**
+ * @namespace NaschKernel
+ * @brief Batched NaSch velocity update over contiguous lane arrays (SIMD with scalar fallback)
+ */
+namespace NaschKernel {
+
+/** Largest vmax the int16 lane arrays hold (gaps are capped at vmax + 1) */
+constexpr int MAX_VMAX = INT16_MAX - 1;
+
+/**
+ * @enum Isa
+ * @brief Kernel implementations, ordered from slowest to fastest
+ */
+enum class Isa {
+    Scalar,     ///< Plain C++
+    SSE41,      ///< 8 vehicles per instruction
+    AVX2,       ///< 16 vehicles per instruction
+    AVX512      ///< 32 vehicles per instruction (AVX-512BW)
+};
+
+/**
+ * @brief Gets the fastest implementation the CPU supports (detected once)
+ */
+Isa best();
+
+/**
+ * @brief Checks if the CPU supports given implementation
+ */
+bool supported(Isa isa);
+
+/**
+ * @brief Gets printable name of an implementation
+ */
+const char* name(Isa isa);
+
+/**
+ * @brief Applies NaSch acceleration, gap clamp and random braking to n vehicles in place:
+ *        vel[i] = max(min(vel[i] + 1, vmax, gap[i] - 1) - brake[i], 0)
+ * @param vel Velocities (updated in place)
+ * @param gap Distances to the next obstacle (>= 1)
+ * @param brake Random braking flags (0 or 1)
+ * @param n Number of vehicles
+ * @param vmax Max velocity
+ * @param isa Implementation to use (must be supported)
+ */
+void apply(int16_t* vel, const int16_t* gap, const int16_t* brake, int n, int vmax, Isa isa);
+
+/**
+ * @brief Applies the kernel using the fastest supported implementation
+ */
+inline void apply(int16_t* vel, const int16_t* gap, const int16_t* brake, int n, int vmax) {
+    apply(vel, gap, brake, n, vmax, best());
+}
+
+} // namespace NaschKernel
+
+#endif // NASCH_KERNEL_HPP
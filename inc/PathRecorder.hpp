@@ -0,0 +1,129 @@
+/**
+ * @file PathRecorder.hpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#ifndef PATH_RECORDER_HPP
+#define PATH_RECORDER_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief How a recorded path ended
+ */
+enum class PathEnd : uint8_t {
+    EXITED,     ///< Vehicle left the grid
+    LOST,       ///< Vehicle was removed in a merge
+    ON_GRID     ///< Vehicle was still on the grid when recording stopped
+};
+
+/**
+ * @class PathRecorder
+ * @brief Full position history of every spawned vehicle, delta and varint encoded (scripts/read_paths.py reads it).
+ *
+ * File (values in the writer's byte order, as checkpoints):
+ *   char[8] magic "TRAFPTH1", uint32 width, uint32 height, then blocks until the end of the file:
+ *   uint32 payload bytes, uint32 record count, payload.
+ * A block holds the paths of vehicles that finished in the same period, one record each (all varints,
+ * signed values zigzag encoded, spawn steps relative to the previous record of the block):
+ *   id, spawn step delta, x, y (at the spawn step), steps << 2 | PathEnd,
+ *   then steps - 1 moves: zigzag(dx) and zigzag(dy) with interleaved bits (one byte for moves up to 7 cells).
+ */
+class PathRecorder {
+public:
+    /**
+     * @brief Creates the file and writes its header
+     * @return False if the file cannot be created
+     */
+    bool open(const std::string& filename, int width, int height);
+
+    /**
+     * @brief Writes paths of vehicles still on the grid and the last block, then closes the file
+     */
+    void close();
+
+    /**
+     * @brief Starts the path of a vehicle spawned into given vehicle-table slot
+     */
+    void start(int slot, int vehicleId, int spawnStep);
+
+    /**
+     * @brief Appends the position of the vehicle in given slot at the current step
+     */
+    void record(int slot, int x, int y) {
+        Path& path = paths[slot];
+        if (path.steps++ == 0) {
+            path.x = path.lastX = x;
+            path.y = path.lastY = y;
+            return;
+        }
+        putVarint(path.moves, interleave(zigzag(x - path.lastX), zigzag(y - path.lastY)));
+        path.lastX = x;
+        path.lastY = y;
+    }
+
+    /**
+     * @brief Ends the path of the vehicle in given slot and queues it for the next block
+     */
+    void finish(int slot, PathEnd end);
+
+    /**
+     * @brief Gets bytes written so far (header and complete blocks)
+     */
+    uint64_t getBytesWritten() const { return bytesWritten; }
+
+private:
+    /**
+     * @brief Path of one vehicle on the grid
+     */
+    struct Path {
+        int vehicleId = -1;     ///< -1 = slot not recorded
+        int spawnStep = 0;
+        int steps = 0;          ///< Recorded positions
+        int x = 0, y = 0;       ///< First position
+        int lastX = 0, lastY = 0;
+        std::string moves;      ///< Encoded moves after the first position
+    };
+
+    static constexpr size_t BLOCK_SIZE = 1 << 16;   ///< Payload size that triggers writing a block
+
+    static uint32_t zigzag(int value) {
+        return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    }
+
+    /**
+     * @brief Interleaves bits of two values (a in even bits), small pairs give small numbers
+     */
+    static uint64_t interleave(uint32_t a, uint32_t b) {
+        uint64_t result = 0;
+        for (int bit = 0; (a | b) >> bit; bit++) {
+            result |= static_cast<uint64_t>((a >> bit) & 1) << (2 * bit);
+            result |= static_cast<uint64_t>((b >> bit) & 1) << (2 * bit + 1);
+        }
+        return result;
+    }
+
+    static void putVarint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    /**
+     * @brief Writes the current block
+     */
+    void writeBlock();
+
+    std::ofstream file;
+    std::vector<Path> paths;        ///< Open paths by slot
+    std::string block;              ///< Payload of the current block
+    uint32_t blockRecords = 0;
+    int lastSpawn = 0;              ///< Spawn step of the previous record of the block
+    uint64_t bytesWritten = 0;
+};
+
+#endif // PATH_RECORDER_HPP
@@ -0,0 +1,67 @@
+/**
+ * @file QuantileSketch.hpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#ifndef QUANTILE_SKETCH_HPP
+#define QUANTILE_SKETCH_HPP
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class QuantileSketch
+ * @brief Log-linear histogram of non-negative integers (HDR histogram layout) for streaming quantiles.
+ *
+ * Values below 128 get a bucket each (exact), every higher power of two is split into 64 buckets,
+ * so a quantile is off by less than 1% of its value. Memory depends only on the largest value
+ * (under 14 KiB for any int), and sketches merge exactly by adding bucket counts.
+ */
+class QuantileSketch {
+public:
+    /**
+     * @brief Adds one value (negative values count as 0)
+     */
+    void add(long long value);
+
+    /**
+     * @brief Removes one value added before (min and max may widen to the bounds of their bucket)
+     */
+    void remove(long long value);
+
+    /**
+     * @brief Adds all values of another sketch
+     */
+    void merge(const QuantileSketch& other);
+
+    /**
+     * @brief Gets the value at given quantile (midpoint of its bucket, 0 if the sketch is empty)
+     * @param q Quantile (0-1)
+     */
+    double quantile(double q) const;
+
+    uint64_t count() const { return total; }
+    double mean() const { return total > 0 ? static_cast<double>(sum) / total : 0.0; }
+    long long max() const { return maxValue; }
+
+    void clear();
+
+private:
+    static constexpr int LINEAR = 128;  ///< Values with a bucket of their own
+    static constexpr int SUB = 64;      ///< Buckets per power of two above LINEAR
+
+    static int bucketOf(uint64_t value);
+
+    /**
+     * @brief Gets the smallest value and the width of a bucket
+     */
+    static uint64_t lowerBound(int bucket);
+    static uint64_t width(int bucket);
+
+    std::vector<uint64_t> counts;   ///< Count of each bucket (up to the highest one used)
+    uint64_t total = 0;
+    long long sum = 0;
+    long long minValue = 0;
+    long long maxValue = 0;
+};
+
+#endif // QUANTILE_SKETCH_HPP
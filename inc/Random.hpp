@@ -0,0 +1,89 @@
+/**
+ * @file Random.hpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include <array>
+#include <cstdint>
+
+/**
+ * @enum RngStream
+ * @brief Independent random streams, one per kind of decision
+ */
+enum class RngStream : uint32_t {
+    Spawn,          ///< Spawn test of a spawn point
+    SpawnVelocity,  ///< Initial velocity of a spawned car
+    SpawnTurn,      ///< Turn intention of a spawned car
+    Braking         ///< NaSch random braking
+};
+
+/**
+ * @class CounterRng
+ * @brief Counter-based generator (Philox4x32-10). A draw is a pure function of
+ *        (seed, step, entity, stream), so results do not depend on evaluation order.
+ */
+class CounterRng {
+public:
+    /**
+     * @brief Constructor
+     * @param seed 64-bit seed (used as Philox key)
+     */
+    explicit CounterRng(uint64_t seed = 0) { setSeed(seed); }
+
+    void setSeed(uint64_t s) {
+        seed = s;
+        key = {static_cast<uint32_t>(s), static_cast<uint32_t>(s >> 32)};
+    }
+    uint64_t getSeed() const { return seed; }
+
+    /**
+     * @brief Generates four random words for a counter
+     * @param step Simulation step
+     * @param entity Vehicle ID or cell index the draw belongs to
+     * @param stream Kind of decision
+     * @return Four independent 32-bit words
+     */
+    std::array<uint32_t, 4> block(uint32_t step, uint32_t entity, RngStream stream) const {
+        std::array<uint32_t, 4> ctr = {step, entity, static_cast<uint32_t>(stream), 0};
+        std::array<uint32_t, 2> k = key;
+        for (int round = 0; round < 10; round++) {
+            uint64_t p0 = static_cast<uint64_t>(M0) * ctr[0];
+            uint64_t p1 = static_cast<uint64_t>(M1) * ctr[2];
+            ctr = {static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ k[0], static_cast<uint32_t>(p1),
+                   static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ k[1], static_cast<uint32_t>(p0)};
+            k[0] += W0;
+            k[1] += W1;
+        }
+        return ctr;
+    }
+
+    /**
+     * @brief Uniform double in [0, 1) with 53 random bits
+     */
+    double uniform(uint32_t step, uint32_t entity, RngStream stream) const {
+        std::array<uint32_t, 4> r = block(step, entity, stream);
+        uint64_t bits = (static_cast<uint64_t>(r[0]) << 21) ^ (r[1] >> 11);
+        return static_cast<double>(bits) * (1.0 / 9007199254740992.0);
+    }
+
+    /**
+     * @brief Uniform integer in [0, n)
+     */
+    int below(int n, uint32_t step, uint32_t entity, RngStream stream) const {
+        std::array<uint32_t, 4> r = block(step, entity, stream);
+        return static_cast<int>((static_cast<uint64_t>(r[0]) * static_cast<uint32_t>(n)) >> 32);
+    }
+
+private:
+    static constexpr uint32_t M0 = 0xD2511F53;  ///< Philox multipliers
+    static constexpr uint32_t M1 = 0xCD9E8D57;
+    static constexpr uint32_t W0 = 0x9E3779B9;  ///< Weyl key increments
+    static constexpr uint32_t W1 = 0xBB67AE85;
+
+    uint64_t seed = 0;
+    std::array<uint32_t, 2> key = {0, 0};
+};
+
+#endif // RANDOM_HPP
@@ -6,6 +6,8 @@
 #ifndef RULES_HPP
 #define RULES_HPP
 
+#include <algorithm>
+
 /**
  * @class Rules
  * @brief Abstract base class defining rules for the CA
@@ -16,8 +18,13 @@ public:
 
     /**
      * @brief Determines the next velocity of a cell (abstract, but for NS we override in subclass)
+     * @param currentVel Current velocity
+     * @param distToNext Distance to the next obstacle
+     * @param vmax Max velocity
+     * @param p Braking probability
+     * @param r Uniform random draw in [0, 1) belonging to this car and step
      */
-    virtual int nextVelocity(int currentVel, int distToNext, int vmax, double p) const = 0;
+    virtual int nextVelocity(int currentVel, int distToNext, int vmax, double p, double r) const = 0;
 };
 
 /**
@@ -26,7 +33,7 @@ public:
  */
 // class GameOfLifeRules : public Rules {
 // public:
-//     int nextVelocity(int currentVel, int distToNext, int vmax, double p) const override {
+//     int nextVelocity(int currentVel, int distToNext, int vmax, double p, double r) const override {
 //         // Not used
 //         return 0;
 //     }
@@ -36,9 +43,23 @@ public:
  * @class NSRules
  * @brief Nagel-Schreckenberg rules for traffic flow
  */
-class NSRules : public Rules {
+class NSRules final : public Rules {
 public:
-    int nextVelocity(int currentVel, int distToNext, int vmax, double p) const override;
+    /**
+     * @brief Branch-free NaSch step, defined inline so it folds into callers that know the type
+     */
+    int nextVelocity(int currentVel, int distToNext, int vmax, double p, double r) const override {
+        // 1. Acceleration
+        int v = std::min(currentVel + 1, vmax);
+
+        // 2. Deceleration
+        v = std::min(v, distToNext - 1);
+
+        // 3. Randomization
+        v -= static_cast<int>(r < p) & static_cast<int>(v > 0);
+
+        return v;
+    }
 };
 
 #endif // RULES_HPP
\ No newline at end of file
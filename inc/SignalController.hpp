@@ -0,0 +1,110 @@
+/**
+ * @file SignalController.hpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#ifndef SIGNAL_CONTROLLER_HPP
+#define SIGNAL_CONTROLLER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Light shown by a signal group
+ */
+enum class SignalState : uint8_t {
+    RED,
+    YELLOW,
+    GREEN
+};
+
+/**
+ * @class SignalController
+ * @brief Fixed-time phase plan of the junction. Every signal group is green once per cycle;
+ *        the controller jumps from one phase change to the next instead of ticking per-light timers.
+ */
+class SignalController {
+public:
+    /**
+     * @brief Removes all groups
+     */
+    void clear();
+
+    /**
+     * @brief Adds a signal group
+     * @param start Step within the cycle at which the group turns green
+     * @param green Green time including yellow
+     * @param yellow Yellow time at the end of green
+     * @return Group index
+     */
+    int addGroup(int start, int green, int yellow);
+
+    /**
+     * @brief Sets cycle length and rewinds the plan to step 0 (call after all groups are added)
+     * @param length Cycle length in steps
+     */
+    void setCycle(int length);
+
+    /**
+     * @brief Jumps to a step of the plan (restoring a checkpoint), lights are recomputed from the plan
+     * @param at Steps advanced since setCycle()
+     */
+    void setStep(int at);
+
+    /**
+     * @brief Advances the plan by one step
+     * @return True if some group changed its light (listed by getChanged())
+     */
+    bool advance();
+
+    /**
+     * @brief Gets light of a group
+     */
+    SignalState getState(int group) const { return states[group]; }
+
+    /**
+     * @brief Gets groups whose light changed in the last advance()
+     */
+    const std::vector<int>& getChanged() const { return changed; }
+
+    /**
+     * @brief Getters
+     */
+    int getGroupCount() const { return static_cast<int>(groups.size()); }
+    int getCycle() const { return cycle; }
+    int getStep() const { return step; }
+
+private:
+    /**
+     * @brief Timing of a signal group within the cycle
+     */
+    struct Group {
+        int start;
+        int green;
+        int yellow;
+    };
+
+    /**
+     * @brief Phase change of a group at a fixed step within the cycle
+     */
+    struct Event {
+        int offset;
+        int group;
+    };
+
+    /**
+     * @brief Computes light of a group at a step within the cycle
+     */
+    SignalState stateAt(int group, int phase) const;
+
+    std::vector<Group> groups;
+    std::vector<SignalState> states;    ///< Current light of every group (contiguous, one byte each)
+    std::vector<Event> events;          ///< Phase changes of one cycle ordered by offset
+    std::vector<int> changed;           ///< Groups changed by the last advance()
+    size_t nextEvent = 0;               ///< Next event to fire
+    int cycle = 0;                      ///< Cycle length
+    int step = 0;                       ///< Steps advanced since setCycle()
+    int phase = 0;                      ///< step % cycle
+};
+
+#endif // SIGNAL_CONTROLLER_HPP
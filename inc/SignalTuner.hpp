@@ -0,0 +1,123 @@
+/**
+ * @file SignalTuner.hpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#ifndef SIGNAL_TUNER_HPP
+#define SIGNAL_TUNER_HPP
+
+#include "Logger.hpp"
+#include "Simulation.hpp"
+#include "ThreadPool.hpp"
+#include <string>
+#include <vector>
+
+/**
+ * @brief KPI a signal plan is tuned for
+ */
+enum class TuningObjective {
+    Throughput,     ///< Maximize exited vehicles per minute
+    Delay           ///< Minimize vehicle-steps spent in the system per spawned vehicle (cars still queued count too)
+};
+
+/**
+ * @brief Search settings of the signal tuner
+ */
+struct TuningOptions {
+    TuningObjective objective = TuningObjective::Throughput;
+    int replicas = 1;           ///< Runs per plan (seeds base..base+replicas-1, shared by all plans)
+    int initialStep = 16;       ///< First change of a green duration (steps)
+    int minStep = 2;            ///< Search stops once the step shrinks below this
+    int minGreen = 10;          ///< Lower bound of every green duration
+    int maxGreen = 240;         ///< Upper bound of every green duration
+    int budget = 200;           ///< Maximum number of evaluated plans
+    int checkpoints = 10;       ///< Points of a run where a candidate is compared to the incumbent
+    double margin = 0.10;       ///< Candidate is abandoned once its cost exceeds the incumbent's by this fraction
+};
+
+/**
+ * @brief Result of one evaluated signal plan
+ */
+struct TuningEvaluation {
+    int round;                  ///< Search round (0 is the starting plan)
+    SignalPlan plan;
+    double cost;                ///< Mean objective cost over replicas (lower is better, at the earliest failed checkpoint if abandoned)
+    double throughput;          ///< Mean exited vehicles per minute
+    double delay;               ///< Mean vehicle-steps in the system per spawned vehicle
+    bool abandoned;             ///< True if stopped early for being clearly worse than the incumbent
+    long long stepsRun;         ///< Simulated steps over all replicas (up to the reported checkpoint if abandoned)
+};
+
+/**
+ * @class SignalTuner
+ * @brief Coordinate descent over the green durations of the signal plan. Every round evaluates
+ *        plan +/- step for each green in parallel, moves to the best improvement or halves the step.
+ *        Candidate runs are checked against the incumbent at fixed checkpoints and stopped early
+ *        once they are clearly worse.
+ */
+class SignalTuner {
+public:
+    /**
+     * @brief Constructor
+     * @param base Configuration to tune (its signal plan is the starting point)
+     * @param options Search settings
+     */
+    SignalTuner(const SimulationConfig& base, const TuningOptions& options);
+
+    /**
+     * @brief Parses an objective name ("throughput" or "delay")
+     * @return False if the name is unknown
+     */
+    static bool parseObjective(const std::string& name, TuningObjective& out);
+
+    /**
+     * @brief Runs the search
+     * @param pool Pool the candidate runs are spread over
+     * @return Best plan found
+     */
+    SignalPlan run(ThreadPool& pool);
+
+    /**
+     * @brief Prints the starting and best plan and how much simulation early termination saved
+     */
+    void printTable() const;
+
+    /**
+     * @brief Exports one row per evaluated plan to CSV
+     */
+    void exportCsv(const std::string& filename) const;
+
+    const std::vector<TuningEvaluation>& getEvaluations() const { return evaluations; }
+    const SignalPlan& getBest() const { return best; }
+
+private:
+    /**
+     * @brief Runs all replicas of the candidate plans, candidates worse than the incumbent are abandoned
+     * @param pool Pool the runs are spread over
+     * @param plans Candidate plans
+     * @param round Search round recorded with the results
+     * @param reference Cost of the incumbent per replica and checkpoint (empty to run every candidate fully)
+     * @param traces Filled with cost per replica and checkpoint of every candidate
+     * @return One evaluation per candidate
+     */
+    std::vector<TuningEvaluation> evaluate(ThreadPool& pool, const std::vector<SignalPlan>& plans, int round,
+                                           const std::vector<std::vector<double>>& reference,
+                                           std::vector<std::vector<std::vector<double>>>& traces) const;
+
+    /**
+     * @brief Cost of a (partial) run under the tuned objective
+     */
+    double cost(const SummaryStatistics& summary) const;
+
+    /**
+     * @brief Gets green durations of a plan in search order, or sets them
+     */
+    static int& green(SignalPlan& plan, int index);
+
+    SimulationConfig base;
+    TuningOptions options;
+    SignalPlan best;
+    double bestCost = 0.0;
+    std::vector<TuningEvaluation> evaluations;
+};
+
+#endif // SIGNAL_TUNER_HPP
@@ -0,0 +1,121 @@
+/**
+ * @file Simulation.hpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#ifndef SIMULATION_HPP
+#define SIMULATION_HPP
+
+#include "Grid.hpp"
+#include "Logger.hpp"
+#include "Rules.hpp"
+#include "SteadyState.hpp"
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Parameters of one simulation run
+ */
+struct SimulationConfig {
+    int width = 100;            ///< Grid width
+    int height = 100;           ///< Grid height
+    int steps = 1000;           ///< Number of steps
+    int vmax = 3;               ///< Max velocity
+    double prob = 0.3;          ///< Braking probability
+    double density = 0.5;       ///< Initial car density (0-1)
+    bool optimize = false;      ///< Modified intersection layout
+    double inflow = 1.0;        ///< Factor applied to spawn probabilities
+    SignalPlan signals;         ///< Green durations of the signal groups
+    uint64_t seed = 0;          ///< Random seed
+    double steadyTarget = 0.0;  ///< Stop once throughput and velocity are known within this relative 95% CI (0 = run all steps)
+    bool headless = false;      ///< Update without logging hooks (summary only has counts and throughput)
+    bool vehicleRecords = false;///< Keep a record of every vehicle for vehicle_trajectories.csv (memory grows with spawned vehicles)
+    LogSampling sampling;       ///< Timestep stride, vehicle sample rate and heatmap regions of the logger
+};
+
+/**
+ * @class Simulation
+ * @brief Grid with its logger and rules, stepped with the update matching the configured vmax
+ */
+class Simulation {
+public:
+    /**
+     * @brief Builds the intersection for given configuration
+     * @param config Run parameters
+     */
+    explicit Simulation(const SimulationConfig& config);
+
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    /**
+     * @brief Advances the simulation by one step
+     */
+    void step();
+
+    /**
+     * @brief Runs all remaining steps
+     * @return KPIs of the whole run
+     */
+    SummaryStatistics run();
+
+    /**
+     * @brief Computes KPIs of the steps done so far (headless runs only report counts,
+     *        completion rate and throughput)
+     */
+    SummaryStatistics summary() const;
+
+    /**
+     * @brief Writes the full state (step, grid, logger) to a binary checkpoint file.
+     *        The file is written next to the target and renamed, so a crash never leaves a partial checkpoint.
+     * @param path Checkpoint file
+     * @return False (with message on stderr) if the file cannot be written
+     */
+    bool saveCheckpoint(const std::string& path) const;
+
+    /**
+     * @brief Continues from a checkpoint written by saveCheckpoint(). The layout (width, height,
+     *        --optimize) must match; speed limit, braking, demand and signal plan may differ,
+     *        so scenario variants can branch from one warmed-up state.
+     * @param path Checkpoint file
+     * @return False (with message on stderr) if the file cannot be read or does not fit
+     */
+    bool restoreCheckpoint(const std::string& path);
+
+    /**
+     * @brief Checks if all configured steps were done or the steady state is known precisely enough
+     */
+    bool finished() const { return currentStep >= config.steps || steadyState.converged(); }
+
+    /**
+     * @brief Checks if the run stopped early in steady state
+     */
+    bool reachedSteadyState() const { return steadyState.converged(); }
+
+    const SteadyStateDetector& getSteadyState() const { return steadyState; }
+
+    /**
+     * @brief Getters
+     */
+    int getStep() const { return currentStep; }
+    const SimulationConfig& getConfig() const { return config; }
+    Grid& getGrid() { return grid; }
+    const Grid& getGrid() const { return grid; }
+    Logger& getLogger() { return logger; }
+    const Logger& getLogger() const { return logger; }
+
+private:
+    /**
+     * @brief Runs one grid update with or without the logging hooks
+     */
+    template <bool Logged>
+    void advance();
+
+    SimulationConfig config;
+    Grid grid;
+    Logger logger;
+    NSRules rules;
+    SteadyStateDetector steadyState;    ///< Warm-up truncation of the logged summary (if steadyTarget is set)
+    int currentStep = 0;    ///< Number of steps done
+};
+
+#endif // SIMULATION_HPP
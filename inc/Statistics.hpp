@@ -0,0 +1,25 @@
+/**
+ * @file Statistics.hpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#ifndef STATISTICS_HPP
+#define STATISTICS_HPP
+
+#include <vector>
+
+/**
+ * @brief Mean of a KPI over independent samples (replicas, batch means) with its 95% confidence interval
+ */
+struct KpiEstimate {
+    double mean = 0.0;
+    double stddev = 0.0;        ///< Sample standard deviation
+    double ciHalfWidth = 0.0;   ///< Half-width of the 95% CI (Student t)
+    int samples = 0;
+};
+
+/**
+ * @brief Computes mean, sample stddev and 95% CI half-width of samples
+ */
+KpiEstimate estimateKpi(const std::vector<double>& samples);
+
+#endif // STATISTICS_HPP
@@ -0,0 +1,114 @@
+/**
+ * @file SteadyState.hpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#ifndef STEADY_STATE_HPP
+#define STEADY_STATE_HPP
+
+#include "Logger.hpp"
+#include "Statistics.hpp"
+#include <istream>
+#include <ostream>
+#include <vector>
+
+/**
+ * @class SteadyStateDetector
+ * @brief Online warm-up truncation (MSER-5) and batch means CI of throughput and average velocity.
+ *        Steps are averaged into batches of 5; every few batches the truncation point minimizing
+ *        the MSER statistic is recomputed and the steady-state part is split into 20 batch means.
+ */
+class SteadyStateDetector {
+public:
+    /**
+     * @brief Constructor
+     * @param target Relative 95% CI half-width both series have to reach (0 disables detection)
+     */
+    explicit SteadyStateDetector(double target = 0.0);
+
+    /**
+     * @brief Adds metrics of the next step (steps have to come in order)
+     */
+    void observe(const TimestepMetrics& metrics);
+
+    /**
+     * @brief Forgets all observed steps
+     */
+    void reset();
+
+    /**
+     * @brief Checks if the steady-state estimate of both series is precise enough
+     */
+    bool converged() const { return done; }
+
+    /**
+     * @brief Gets number of leading steps that are warm-up (as of the last evaluation)
+     */
+    int getWarmupSteps() const { return warmupBatches * BATCH; }
+
+    /**
+     * @brief Gets steady-state estimates (exited vehicles per step, cells per step)
+     */
+    const KpiEstimate& getThroughput() const { return throughput; }
+    const KpiEstimate& getVelocity() const { return velocity; }
+
+    bool isEnabled() const { return target > 0.0; }
+
+    /**
+     * @brief Gets number of observed steps
+     */
+    int getObserved() const { return observed; }
+
+    /**
+     * @brief Writes/reads observed batches and the last evaluation (checkpoints). The target is not
+     *        stored, convergence is checked against this detector's own target after loading.
+     */
+    void save(std::ostream& out) const;
+    bool load(std::istream& in);
+
+private:
+    static constexpr int BATCH = 5;         ///< Steps per MSER batch
+    static constexpr int GROUPS = 20;       ///< Batch means of the steady-state part
+    static constexpr int MIN_BATCHES = 100; ///< Observed batches before stopping is considered
+    static constexpr int EVERY = 10;        ///< Batches between evaluations
+
+    /**
+     * @brief Batch averages of one observed series
+     */
+    struct Series {
+        std::vector<double> batches;
+        double partial = 0.0;   ///< Sum of the current incomplete batch
+    };
+
+    /**
+     * @brief Finds the MSER truncation point of a series (searched in its first half)
+     * @return Number of leading batches to drop
+     */
+    static int truncation(const Series& series);
+
+    /**
+     * @brief Estimates mean and CI of a series from GROUPS batch means after the warm-up
+     */
+    KpiEstimate estimate(const Series& series) const;
+
+    /**
+     * @brief Recomputes warm-up and estimates, sets done once both series are precise enough
+     */
+    void evaluate();
+
+    /**
+     * @brief Sets done if the last estimates of both series are precise enough
+     */
+    void checkConverged();
+
+    double target;
+    Series exits;               ///< Vehicles exited per step
+    Series speeds;              ///< Average velocity per step
+    int observed = 0;           ///< Observed steps
+    int lastExited = 0;         ///< Cumulative exits of the previous step
+    int warmupBatches = 0;
+    KpiEstimate throughput;
+    KpiEstimate velocity;
+    bool done = false;
+};
+
+#endif // STEADY_STATE_HPP
@@ -0,0 +1,110 @@
+/**
+ * @file Sweep.hpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+
+#include "Logger.hpp"
+#include "Simulation.hpp"
+#include "ThreadPool.hpp"
+#include <string>
+#include <vector>
+
+/**
+ * @brief Values one parameter takes in a sweep
+ */
+struct SweepParameter {
+    std::string name;
+    std::vector<double> values;
+};
+
+/**
+ * @brief Result of one run of a sweep
+ */
+struct SweepRun {
+    int point;                  ///< Index of the parameter combination
+    int replica;                ///< Replica of the combination (seed = base seed + replica)
+    SimulationConfig config;
+    SummaryStatistics summary;
+    double measuredDensity;     ///< Mean cars in system per road cell
+    double seconds;             ///< Wall time of the run
+};
+
+/**
+ * @class Sweep
+ * @brief Cartesian product of parameter ranges run in one process on a work-stealing pool
+ */
+class Sweep {
+public:
+    /**
+     * @brief Constructor
+     * @param base Configuration the swept parameters are applied to
+     */
+    explicit Sweep(const SimulationConfig& base);
+
+    /**
+     * @brief Adds a swept parameter
+     * @param spec "name=from:to:step" or "name=v1,v2,..." (names as listed by parameterNames())
+     * @return False (with message on stderr) if the spec is invalid
+     */
+    bool addParameter(const std::string& spec);
+
+    /**
+     * @brief Adds swept parameters from a file (one spec per line, '#' starts a comment)
+     * @return False if the file cannot be read or a spec is invalid
+     */
+    bool loadFile(const std::string& path);
+
+    /**
+     * @brief Gets names of parameters that can be swept
+     */
+    static const char* parameterNames();
+
+    /**
+     * @brief Runs every parameter combination replicas times
+     * @param pool Pool the runs are spread over
+     * @param replicas Runs per combination
+     */
+    void run(ThreadPool& pool, int replicas);
+
+    /**
+     * @brief Prints one row per combination (means over replicas, flow with 95% CI)
+     */
+    void printTable() const;
+
+    /**
+     * @brief Exports one row per run (parameters, measured density, KPIs) to CSV
+     */
+    void exportCsv(const std::string& filename) const;
+
+    /**
+     * @brief Gets number of parameter combinations
+     */
+    int points() const;
+
+    const std::vector<SweepRun>& getRuns() const { return runs; }
+
+private:
+    /**
+     * @brief Gets values of all swept parameters in a combination
+     */
+    std::vector<double> pointValues(int point) const;
+
+    /**
+     * @brief Builds configuration of a parameter combination
+     */
+    SimulationConfig pointConfig(int point) const;
+
+    /**
+     * @brief Sets a named parameter of a configuration
+     * @return False if the name is unknown
+     */
+    static bool applyParameter(SimulationConfig& config, const std::string& name, double value);
+
+    SimulationConfig base;
+    std::vector<SweepParameter> parameters;
+    std::vector<SweepRun> runs;
+};
+
+#endif // SWEEP_HPP
@@ -0,0 +1,92 @@
+/**
+ * @file ThreadPool.hpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ThreadPool
+ * @brief Persistent worker threads for fork-join loops (the calling thread works too).
+ *        Every thread starts on its own contiguous block of indices; a thread that runs out
+ *        steals the upper half of the remaining block of another thread, so uneven tasks balance out.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Constructor
+     * @param threads Total number of threads including the caller (>= 1)
+     */
+    explicit ThreadPool(int threads);
+
+    /** Destructor (joins workers) */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Gets number of threads including the caller
+     */
+    int size() const { return static_cast<int>(workers.size()) + 1; }
+
+    /**
+     * @brief Runs fn(i) for every i in [0, n) and waits until all calls finish
+     * @param n Number of tasks
+     * @param fn Task body, must be safe to call concurrently for different indices
+     */
+    void parallelFor(int n, const std::function<void(int)>& fn);
+
+private:
+    /**
+     * @brief Remaining index range of one thread
+     */
+    struct WorkQueue {
+        std::mutex mutex;
+        int begin = 0;
+        int end = 0;
+    };
+
+    /**
+     * @brief Takes the next index of a thread's own block
+     * @return Index or -1 if the block is empty
+     */
+    int pop(int self);
+
+    /**
+     * @brief Moves the upper half of another thread's block into a thread's own block
+     * @return True if anything was stolen
+     */
+    bool steal(int self);
+
+    /**
+     * @brief Runs tasks of the current job on thread self until no thread has any left
+     */
+    void runTasks(int self);
+
+    /**
+     * @brief Worker thread body
+     * @param self Thread index (0 is the caller)
+     */
+    void workerLoop(int self);
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkQueue>> queues; ///< One per thread, index 0 belongs to the caller
+    std::mutex mutex;
+    std::condition_variable wake;                   ///< Signals a new job (or shutdown) to workers
+    std::condition_variable done;                   ///< Signals the caller that all workers finished
+    const std::function<void(int)>* job = nullptr;  ///< Current job
+    int busy = 0;                                   ///< Workers still running the current job
+    uint64_t generation = 0;                        ///< Incremented for every job
+    bool stopping = false;
+};
+
+#endif // THREAD_POOL_HPP
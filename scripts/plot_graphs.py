@@ -9,6 +9,7 @@ import seaborn as sns
 import numpy as np
 import matplotlib as mpl
 from pathlib import Path
+import struct
 import sys
 
 # Hypothesis thresholds
@@ -22,6 +23,9 @@ TIMESTEP_FILE = "timestep_metrics.csv"
 SPATIAL_FILE = "spatial_heatmap.csv"
 TRAJECTORY_FILE = "vehicle_trajectories.csv"
 
+# Columnar binary exports (--columnar) replace these two CSV files
+COLUMNAR_FILES = {TIMESTEP_FILE: "timestep_metrics.col", TRAJECTORY_FILE: "vehicle_trajectories.col"}
+
 # Lane configuration for queue normalization
 BASELINE_EAST_LANES = 3
 MODIFIED_EAST_LANES = 4
@@ -36,6 +40,39 @@ plt.style.use('seaborn-v0_8-darkgrid')
 sns.set_palette("husl")
 
 
+# DATA LOADING
+
+def read_columnar(path):
+    """Map a .col file (see ColumnWriter.hpp) into a DataFrame without parsing"""
+    with open(path, 'rb') as f:
+        header = f.read(32)
+        if header[:8] != b"TRAFCOL1":
+            raise ValueError(f"{path} is not a columnar export")
+        order = chr(header[8])
+        rows, count, _ = struct.unpack(f"{order}QII", header[16:32])
+        entries = [struct.unpack(f"{order}32s8sQ", f.read(48)) for _ in range(count)]
+
+    columns = {}
+    for name, dtype, offset in entries:
+        name = name.rstrip(b"\0").decode()
+        dtype = np.dtype(dtype.rstrip(b"\0").decode())
+        column = (np.memmap(path, dtype=dtype, mode='r', offset=offset, shape=(rows,))
+                  if rows > 0 else np.empty(0, dtype=dtype))
+        # Text columns are fixed-width bytes, numbers stay mapped
+        columns[name] = np.char.decode(column, 'ascii') if dtype.kind == 'S' else column
+    return pd.DataFrame(columns, copy=False)
+
+
+def read_table(data_dir, csv_name):
+    """Load an exported table, preferring the columnar file if it is newer than the CSV"""
+    csv_path = Path(data_dir) / csv_name
+    col_path = Path(data_dir) / COLUMNAR_FILES.get(csv_name, csv_name)
+    if col_path != csv_path and col_path.exists() and (
+            not csv_path.exists() or col_path.stat().st_mtime >= csv_path.stat().st_mtime):
+        return read_columnar(col_path)
+    return pd.read_csv(csv_path)
+
+
 # PLOTTING FUNCTIONS
 def plot_throughput_comparison(baseline_dir, modified_dir, output_dir):
     baseline_summary = pd.read_csv(f"{baseline_dir}/{SUMMARY_FILE}")
@@ -114,8 +151,8 @@ def plot_queue_comparison(baseline_dir, modified_dir, output_dir):
 
 
 def plot_velocity_timeseries(baseline_dir, modified_dir, output_dir):
-    baseline_ts = pd.read_csv(f"{baseline_dir}/{TIMESTEP_FILE}")
-    modified_ts = pd.read_csv(f"{modified_dir}/{TIMESTEP_FILE}")
+    baseline_ts = read_table(baseline_dir, TIMESTEP_FILE)
+    modified_ts = read_table(modified_dir, TIMESTEP_FILE)
 
     fig, ax = plt.subplots(figsize=(14, 6))
 
@@ -135,8 +172,8 @@ def plot_velocity_timeseries(baseline_dir, modified_dir, output_dir):
 
 
 def plot_direction_speeds(baseline_dir, modified_dir, output_dir):
-    baseline_ts = pd.read_csv(f"{baseline_dir}/{TIMESTEP_FILE}")
-    modified_ts = pd.read_csv(f"{modified_dir}/{TIMESTEP_FILE}")
+    baseline_ts = read_table(baseline_dir, TIMESTEP_FILE)
+    modified_ts = read_table(modified_dir, TIMESTEP_FILE)
 
     directions = ['North', 'South', 'East', 'West']
     baseline_speeds = [
@@ -198,8 +235,8 @@ def plot_spatial_heatmap(data_dir, output_dir, scenario_name):
 
 
 def plot_waiting_time_distribution(baseline_dir, modified_dir, output_dir):
-    baseline_veh = pd.read_csv(f"{baseline_dir}/{TRAJECTORY_FILE}")
-    modified_veh = pd.read_csv(f"{modified_dir}/{TRAJECTORY_FILE}")
+    baseline_veh = read_table(baseline_dir, TRAJECTORY_FILE)
+    modified_veh = read_table(modified_dir, TRAJECTORY_FILE)
 
     baseline_veh = baseline_veh[baseline_veh['exitStep'] > 0]
     modified_veh = modified_veh[modified_veh['exitStep'] > 0]
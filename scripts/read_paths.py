@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""
+Reader of vehicle path files recorded with --paths (format in inc/PathRecorder.hpp)
+Authors: Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+"""
+import struct
+import sys
+
+MAGIC = b"TRAFPTH1"
+PATH_ENDS = ("exited", "lost", "onGrid")
+
+
+def _varint(data, pos):
+    """Decode one varint, returns (value, next position)"""
+    value = 0
+    shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if byte < 0x80:
+            return value, pos
+        shift += 7
+
+
+def _unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def _deinterleave(value):
+    """Split interleaved bits into (even bits, odd bits)"""
+    a = b = 0
+    bit = 0
+    while value:
+        a |= (value & 1) << bit
+        b |= ((value >> 1) & 1) << bit
+        value >>= 2
+        bit += 1
+    return a, b
+
+
+def read_header(f):
+    """Read the file header, returns (width, height)"""
+    header = f.read(16)
+    if len(header) < 16 or header[:8] != MAGIC:
+        raise ValueError("not a path file")
+    return struct.unpack("=II", header[8:])
+
+
+def read_paths(path):
+    """
+    Yield every recorded path as (vehicle id, spawn step, end, xs, ys),
+    where xs[i], ys[i] is the cell of the vehicle at step spawn step + i
+    """
+    with open(path, "rb") as f:
+        read_header(f)
+        while True:
+            block_header = f.read(8)
+            if len(block_header) < 8:
+                return
+            size, records = struct.unpack("=II", block_header)
+            data = f.read(size)
+
+            pos = 0
+            spawn = 0
+            for _ in range(records):
+                vehicle_id, pos = _varint(data, pos)
+                delta, pos = _varint(data, pos)
+                spawn += _unzigzag(delta)
+                x, pos = _varint(data, pos)
+                y, pos = _varint(data, pos)
+                steps_end, pos = _varint(data, pos)
+                steps = steps_end >> 2
+
+                xs = [x] if steps > 0 else []
+                ys = [y] if steps > 0 else []
+                for _ in range(steps - 1):
+                    move, pos = _varint(data, pos)
+                    dx, dy = _deinterleave(move)
+                    x += _unzigzag(dx)
+                    y += _unzigzag(dy)
+                    xs.append(x)
+                    ys.append(y)
+                yield vehicle_id, spawn, PATH_ENDS[steps_end & 3], xs, ys
+
+
+def main():
+    if len(sys.argv) < 2:
+        print("Usage: python read_paths.py <paths file> [output.csv]")
+        print("  Without output prints a summary, with it writes one row per vehicle-step (vehicleId,step,x,y).")
+        sys.exit(1)
+
+    if len(sys.argv) >= 3:
+        with open(sys.argv[2], "w") as out:
+            out.write("vehicleId,step,x,y,end\n")
+            for vehicle_id, spawn, end, xs, ys in read_paths(sys.argv[1]):
+                for i, (x, y) in enumerate(zip(xs, ys)):
+                    out.write(f"{vehicle_id},{spawn + i},{x},{y},{end}\n")
+        print(f"Wrote {sys.argv[2]}")
+        return
+
+    with open(sys.argv[1], "rb") as f:
+        width, height = read_header(f)
+    vehicles = 0
+    vehicle_steps = 0
+    ends = dict.fromkeys(PATH_ENDS, 0)
+    for _, _, end, xs, _ in read_paths(sys.argv[1]):
+        vehicles += 1
+        vehicle_steps += len(xs)
+        ends[end] += 1
+    print(f"Grid {width}x{height}: {vehicles} vehicles, {vehicle_steps} vehicle-steps")
+    print("  " + ", ".join(f"{count} {end}" for end, count in ends.items()))
+
+
+if __name__ == "__main__":
+    main()
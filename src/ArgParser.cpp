@@ -3,12 +3,15 @@
  * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
  */
 #include "ArgParser.hpp"
+#include "NaschKernel.hpp"
 #include <iostream>
 #include <string>
+#include <cstdio>
 #include <cstdlib>
+#include <random>
 
 ArgParser::ArgParser(size_t argc, char* argv[])
-    : argc(argc), argv(argv) {}
+    : argc(argc), argv(argv), seed(std::random_device{}()) {}
 
 bool parseInt(const char* s, int& out, const char* flagName) {
     try {
@@ -30,6 +33,19 @@ bool parseDouble(const char* s, double& out, const char* flagName) {
     }
 }
 
+bool parseUInt64(const char* s, uint64_t& out, const char* flagName) {
+    try {
+        size_t used = 0;
+        out = std::stoull(s, &used);
+        if (s[used] != '\0')
+            throw std::invalid_argument(s);
+        return true;
+    } catch (...) {
+        std::cerr << "Error: Invalid unsigned integer for " << flagName << std::endl;
+        return false;
+    }
+}
+
 bool returnWithError(const char* msg) {
     std::cerr << "Error: " << msg << std::endl;
     return false;
@@ -76,7 +92,8 @@ bool ArgParser::parse() {
                 return returnWithError("Missing number for --maxspeed.");
             if (!parseInt(argv[++i], vmax, "--maxspeed")) 
                 return false;
-            if (vmax < 0) return returnWithError("--maxspeed must be non-negative.");
+            if (vmax < 0 || vmax > NaschKernel::MAX_VMAX)
+                return returnWithError(("--maxspeed must be between 0 and " + std::to_string(NaschKernel::MAX_VMAX) + ".").c_str());
         }
         else if (arg == "-P" || arg == "--prob") {
             if (i + 1 >= argc || argv[i + 1][0] == '-') 
@@ -92,7 +109,149 @@ bool ArgParser::parse() {
                 return false;
             if (density < 0.0 || density > 1.0) return returnWithError("--density must be 0-1.");
         }
-        else if (arg == "-0" || "--optimize") {
+        else if (arg == "-S" || arg == "--seed") {
+            if (i + 1 >= argc || argv[i + 1][0] == '-') 
+                return returnWithError("Missing number for --seed.");
+            if (!parseUInt64(argv[++i], seed, "--seed")) 
+                return false;
+        }
+        else if (arg == "-T" || arg == "--threads") {
+            if (i + 1 >= argc || argv[i + 1][0] == '-') 
+                return returnWithError("Missing number for --threads.");
+            if (!parseInt(argv[++i], threads, "--threads")) 
+                return false;
+            if (threads < 1) return returnWithError("--threads must be at least 1.");
+        }
+        else if (arg == "-R" || arg == "--replicas") {
+            if (i + 1 >= argc || argv[i + 1][0] == '-') 
+                return returnWithError("Missing number for --replicas.");
+            if (!parseInt(argv[++i], replicas, "--replicas")) 
+                return false;
+            if (replicas < 1) return returnWithError("--replicas must be at least 1.");
+        }
+        else if (arg == "-J" || arg == "--jobs") {
+            if (i + 1 >= argc || argv[i + 1][0] == '-') 
+                return returnWithError("Missing number for --jobs.");
+            if (!parseInt(argv[++i], jobs, "--jobs")) 
+                return false;
+            if (jobs < 1) return returnWithError("--jobs must be at least 1.");
+        }
+        else if (arg == "--ci-target") {
+            if (i + 1 >= argc || argv[i + 1][0] == '-') 
+                return returnWithError("Missing number for --ci-target.");
+            if (!parseDouble(argv[++i], ciTarget, "--ci-target")) 
+                return false;
+            if (ciTarget <= 0.0) return returnWithError("--ci-target must be positive.");
+        }
+        else if (arg == "--max-replicas") {
+            if (i + 1 >= argc || argv[i + 1][0] == '-') 
+                return returnWithError("Missing number for --max-replicas.");
+            if (!parseInt(argv[++i], maxReplicas, "--max-replicas")) 
+                return false;
+            if (maxReplicas < 2) return returnWithError("--max-replicas must be at least 2.");
+        }
+        else if (arg == "--sweep") {
+            if (i + 1 >= argc) 
+                return returnWithError("Missing range for --sweep.");
+            sweepSpecs.push_back(argv[++i]);
+        }
+        else if (arg == "--sweep-file") {
+            if (i + 1 >= argc) 
+                return returnWithError("Missing path for --sweep-file.");
+            sweepFile = argv[++i];
+        }
+        else if (arg == "--tune-signals") {
+            if (i + 1 >= argc || argv[i + 1][0] == '-') 
+                return returnWithError("Missing objective for --tune-signals.");
+            tuneObjective = argv[++i];
+            if (tuneObjective != "throughput" && tuneObjective != "delay")
+                return returnWithError("--tune-signals must be throughput or delay.");
+        }
+        else if (arg == "--tune-step") {
+            if (i + 1 >= argc || argv[i + 1][0] == '-') 
+                return returnWithError("Missing number for --tune-step.");
+            if (!parseInt(argv[++i], tuneStep, "--tune-step")) 
+                return false;
+            if (tuneStep < 2) return returnWithError("--tune-step must be at least 2.");
+        }
+        else if (arg == "--tune-budget") {
+            if (i + 1 >= argc || argv[i + 1][0] == '-') 
+                return returnWithError("Missing number for --tune-budget.");
+            if (!parseInt(argv[++i], tuneBudget, "--tune-budget")) 
+                return false;
+            if (tuneBudget < 1) return returnWithError("--tune-budget must be at least 1.");
+        }
+        else if (arg == "--checkpoint-every") {
+            if (i + 1 >= argc || argv[i + 1][0] == '-') 
+                return returnWithError("Missing number for --checkpoint-every.");
+            if (!parseInt(argv[++i], checkpointEvery, "--checkpoint-every")) 
+                return false;
+            if (checkpointEvery < 1) return returnWithError("--checkpoint-every must be at least 1.");
+        }
+        else if (arg == "--checkpoint-file") {
+            if (i + 1 >= argc) 
+                return returnWithError("Missing path for --checkpoint-file.");
+            checkpointFile = argv[++i];
+        }
+        else if (arg == "--restore") {
+            if (i + 1 >= argc) 
+                return returnWithError("Missing path for --restore.");
+            restoreFile = argv[++i];
+        }
+        else if (arg == "--steady-state") {
+            if (i + 1 >= argc || argv[i + 1][0] == '-') 
+                return returnWithError("Missing number for --steady-state.");
+            if (!parseDouble(argv[++i], steadyTarget, "--steady-state")) 
+                return false;
+            if (steadyTarget <= 0.0) return returnWithError("--steady-state must be positive.");
+        }
+        else if (arg == "--headless") {
+            headless = true;
+        }
+        else if (arg == "--stream") {
+            stream = true;
+        }
+        else if (arg == "--columnar") {
+            columnar = true;
+        }
+        else if (arg == "--paths") {
+            if (i + 1 >= argc) 
+                return returnWithError("Missing path for --paths.");
+            pathsFile = argv[++i];
+        }
+        else if (arg == "--log-every") {
+            if (i + 1 >= argc || argv[i + 1][0] == '-') 
+                return returnWithError("Missing number for --log-every.");
+            if (!parseInt(argv[++i], logEvery, "--log-every")) 
+                return false;
+            if (logEvery < 1) return returnWithError("--log-every must be at least 1.");
+        }
+        else if (arg == "--sample-vehicles") {
+            if (i + 1 >= argc || argv[i + 1][0] == '-') 
+                return returnWithError("Missing number for --sample-vehicles.");
+            if (!parseDouble(argv[++i], sampleVehicles, "--sample-vehicles")) 
+                return false;
+            if (sampleVehicles < 0.0 || sampleVehicles > 1.0) return returnWithError("--sample-vehicles must be 0-1.");
+        }
+        else if (arg == "--heatmap-roi") {
+            if (i + 1 >= argc || argv[i + 1][0] == '-') 
+                return returnWithError("Missing region for --heatmap-roi.");
+            std::array<int, 4> r;
+            int used = 0;
+            const char* spec = argv[++i];
+            if (std::sscanf(spec, "%d,%d,%d,%d%n", &r[0], &r[1], &r[2], &r[3], &used) != 4 || spec[used] != '\0')
+                return returnWithError("--heatmap-roi must be x0,y0,x1,y1.");
+            if (r[0] > r[2] || r[1] > r[3]) return returnWithError("--heatmap-roi needs x0 <= x1 and y0 <= y1.");
+            heatmapRegions.push_back(r);
+        }
+        else if (arg == "--report-every") {
+            if (i + 1 >= argc || argv[i + 1][0] == '-') 
+                return returnWithError("Missing number for --report-every.");
+            if (!parseInt(argv[++i], reportEvery, "--report-every")) 
+                return false;
+            if (reportEvery < 0) return returnWithError("--report-every must not be negative.");
+        }
+        else if (arg == "-o" || arg == "--optimize") {
             optimize = true;
             continue;
         }
@@ -102,6 +261,16 @@ bool ArgParser::parse() {
             return false;
         }
     }
+    if (headless && (plotFlag || steadyTarget > 0.0))
+        return returnWithError("--headless cannot be combined with --plot or --steady-state (they need logged metrics).");
+    if ((stream || columnar) && !plotFlag)
+        return returnWithError("--stream and --columnar need --plot.");
+    if (stream && columnar)
+        return returnWithError("--stream writes CSV rows as they come, it cannot be combined with --columnar.");
+    if ((stream || !pathsFile.empty()) && (checkpointEvery > 0 || !restoreFile.empty()))
+        return returnWithError("--stream and --paths cannot be combined with checkpoints (written files cannot be rewound).");
+    if (headless && !pathsFile.empty())
+        return returnWithError("--headless cannot be combined with --paths (it needs logged vehicles).");
     return true;
 }
 
@@ -120,5 +289,37 @@ void ArgParser::displayHelp() {
         << "  -M, --maxspeed <n>        Max car velocity (>=0, default 5).\n"
         << "  -P, --prob <f>            Braking probability (random braking) (0-1, default 0.3).\n"
         << "  -D, --density <f>         Initial car density (0-1, default 0.2).\n"
+        << "  -S, --seed <n>            Random seed (default: random, printed at start).\n"
+        << "  -T, --threads <n>         Worker threads for the grid update (>=1, default 1).\n"
+        << "  -R, --replicas <n>        Run n replicas (seeds seed..seed+n-1) and report mean/stddev/95% CI.\n"
+        << "  -J, --jobs <n>            Replicas run in parallel (>=1, default 1).\n"
+        << "      --ci-target <f>       Add replicas until the 95% CI half-width of throughput, time in\n"
+        << "                            system and max queue is below f * mean (e.g. 0.05).\n"
+        << "      --max-replicas <n>    Replica limit for --ci-target (default 200).\n"
+        << "      --sweep <spec>        Sweep a parameter, spec is name=from:to:step or name=v1,v2,...\n"
+        << "                            (repeatable, runs the cartesian product on --jobs threads).\n"
+        << "      --sweep-file <path>   Read sweep specs from a file (one per line, # comments).\n"
+        << "      --tune-signals <obj>  Search green durations for the best throughput or delay\n"
+        << "                            (coordinate descent, --replicas runs per plan on --jobs threads).\n"
+        << "      --tune-step <n>       First change of a green duration (>=2, default 16).\n"
+        << "      --tune-budget <n>     Maximum number of evaluated plans (default 200).\n"
+        << "      --checkpoint-every <n> Save the full state every n steps (overwrites --checkpoint-file).\n"
+        << "      --checkpoint-file <path> Checkpoint written by --checkpoint-every (default checkpoint.bin).\n"
+        << "      --restore <path>      Continue from a checkpoint up to --steps (same width, height, --optimize).\n"
+        << "      --steady-state <f>    Drop the warm-up (MSER-5) from the summary and stop once throughput and\n"
+        << "                            velocity are known within f * mean (95% CI, --steps is the limit).\n"
+        << "      --headless            Single run without logging hooks, reports only counts and throughput.\n"
+        << "      --report-every <n>    Steps between live summary tables (0 = only the final one, default 25).\n"
+        << "      --stream              With --plot, write timestep metrics and vehicle trajectories while the\n"
+        << "                            run goes (background thread, memory does not grow with the run).\n"
+        << "      --columnar            With --plot, write timestep metrics and vehicle trajectories as columnar\n"
+        << "                            binary .col files (numpy.memmap-able, read by plot_graphs.py).\n"
+        << "      --paths <file>        Record every spawned vehicle's position at every step (delta/varint\n"
+        << "                            encoded, about a byte per vehicle-step; read with scripts/read_paths.py).\n"
+        << "      --log-every <k>       Record timestep metrics and heatmap observations every k-th step\n"
+        << "                            (summary averages are over the recorded steps, default 1).\n"
+        << "      --sample-vehicles <f> Track only this fraction of vehicles (0-1, chosen by a hash of the\n"
+        << "                            vehicle ID, a tracked vehicle is recorded for its whole life, default 1).\n"
+        << "      --heatmap-roi <x0,y0,x1,y1> Observe only heatmap cells in this rectangle (repeatable).\n"
         << "  -h, --help                Show this help message.\n";
 }
\ No newline at end of file
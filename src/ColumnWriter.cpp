@@ -0,0 +1,73 @@
+/**
+ * @file ColumnWriter.cpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#include "ColumnWriter.hpp"
+#include "BinaryIO.hpp"
+#include <algorithm>
+#include <fstream>
+
+namespace {
+
+const size_t NAME_SIZE = 32;
+const size_t DTYPE_SIZE = 8;
+const size_t ALIGNMENT = 64;
+
+/**
+ * @brief Writes a string into a fixed-size NUL-padded field
+ */
+void writeField(std::ostream& out, const std::string& text, size_t size) {
+    std::string field = text.substr(0, size);
+    field.resize(size, '\0');
+    out.write(field.data(), static_cast<std::streamsize>(size));
+}
+
+size_t alignUp(size_t offset) {
+    return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+} // namespace
+
+char ColumnWriter::byteOrder() {
+    const uint16_t probe = 1;
+    char first;
+    std::memcpy(&first, &probe, 1);
+    return first ? '<' : '>';
+}
+
+ColumnWriter::Column& ColumnWriter::addColumn(const std::string& name, const std::string& dtype, size_t width) {
+    columns.push_back(Column{name, dtype, std::vector<char>(rows * width, '\0')});
+    return columns.back();
+}
+
+bool ColumnWriter::write(const std::string& filename) const {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out)
+        return false;
+
+    out.write("TRAFCOL1", 8);
+    writeField(out, std::string(1, byteOrder()), 8);
+    BinaryIO::write(out, rows);
+    BinaryIO::write(out, static_cast<uint32_t>(columns.size()));
+    BinaryIO::write(out, uint32_t{0});
+
+    // Offsets of the column arrays after the header
+    size_t offset = alignUp(32 + columns.size() * (NAME_SIZE + DTYPE_SIZE + sizeof(uint64_t)));
+    std::vector<size_t> offsets;
+    for (const Column& column : columns) {
+        offsets.push_back(offset);
+        offset = alignUp(offset + column.data.size());
+    }
+    for (size_t c = 0; c < columns.size(); c++) {
+        writeField(out, columns[c].name, NAME_SIZE);
+        writeField(out, columns[c].dtype, DTYPE_SIZE);
+        BinaryIO::write(out, static_cast<uint64_t>(offsets[c]));
+    }
+
+    for (size_t c = 0; c < columns.size(); c++) {
+        std::string padding(offsets[c] - static_cast<size_t>(out.tellp()), '\0');
+        out.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+        out.write(columns[c].data.data(), static_cast<std::streamsize>(columns[c].data.size()));
+    }
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,115 @@
+/**
+ * @file CsvWriter.cpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#include "CsvWriter.hpp"
+#include <charconv>
+
+CsvWriter::CsvWriter(size_t c) : capacity(c) {
+    current.reserve(capacity + 256);
+    pending.reserve(capacity + 256);
+}
+
+CsvWriter::~CsvWriter() {
+    close();
+}
+
+bool CsvWriter::open(const std::string& filename) {
+    close();
+    file = std::fopen(filename.c_str(), "wb");
+    if (!file)
+        return false;
+    closing = false;
+    failed = false;
+    writer = std::thread(&CsvWriter::writerLoop, this);
+    return true;
+}
+
+bool CsvWriter::close() {
+    if (!file)
+        return true;
+    handOff();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    wake.notify_one();
+    writer.join();
+    bool ok = !failed;
+    if (std::fclose(file) != 0)
+        ok = false;
+    file = nullptr;
+    return ok;
+}
+
+void CsvWriter::separate() {
+    if (rowStarted)
+        current.push_back(',');
+    rowStarted = true;
+}
+
+CsvWriter& CsvWriter::field(int value) {
+    return field(static_cast<long long>(value));
+}
+
+CsvWriter& CsvWriter::field(long long value) {
+    separate();
+    char text[24];
+    char* end = std::to_chars(text, text + sizeof(text), value).ptr;
+    current.append(text, end);
+    return *this;
+}
+
+CsvWriter& CsvWriter::field(double value) {
+    separate();
+    char text[352];     // Enough for any double in fixed notation
+    char* end = std::to_chars(text, text + sizeof(text), value, std::chars_format::fixed, 4).ptr;
+    current.append(text, end);
+    return *this;
+}
+
+CsvWriter& CsvWriter::field(std::string_view value) {
+    separate();
+    current.append(value);
+    return *this;
+}
+
+CsvWriter& CsvWriter::raw(std::string_view text) {
+    current.append(text);
+    return *this;
+}
+
+void CsvWriter::endRow() {
+    current.push_back('\n');
+    rowStarted = false;
+    if (current.size() >= capacity)
+        handOff();
+}
+
+void CsvWriter::handOff() {
+    if (current.empty())
+        return;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return pending.empty(); });
+        std::swap(current, pending);
+    }
+    wake.notify_one();
+}
+
+void CsvWriter::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [this] { return !pending.empty() || closing; });
+        if (pending.empty())
+            return;
+
+        // The caller fills the other buffer meanwhile
+        lock.unlock();
+        bool written = std::fwrite(pending.data(), 1, pending.size(), file) == pending.size();
+        lock.lock();
+        failed = failed || !written;
+        pending.clear();
+        idle.notify_one();
+    }
+}
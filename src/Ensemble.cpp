@@ -0,0 +1,154 @@
+/**
+ * @file Ensemble.cpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#include "Ensemble.hpp"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+/**
+ * @brief KPI of summary_statistics.csv that is aggregated over replicas
+ */
+struct Kpi {
+    const char* name;
+    double (*get)(const SummaryStatistics&);
+};
+
+const Kpi KPIS[] = {
+    {"throughputPerMinute", [](const SummaryStatistics& s) { return s.throughputPerMinute; }},
+    {"avgTimeInSystem",     [](const SummaryStatistics& s) { return s.avgTimeInSystem; }},
+    {"maxQueueLength",      [](const SummaryStatistics& s) { return static_cast<double>(s.maxQueueLength); }},
+    {"avgWaitingTime",      [](const SummaryStatistics& s) { return s.avgWaitingTime; }},
+    {"timeInSystemP95",     [](const SummaryStatistics& s) { return s.timeInSystemP95; }},
+    {"waitingTimeP95",      [](const SummaryStatistics& s) { return s.waitingTimeP95; }},
+    {"avgVelocity",         [](const SummaryStatistics& s) { return s.avgVelocity; }},
+    {"avgStoppedCars",      [](const SummaryStatistics& s) { return s.avgStoppedCars; }},
+    {"completionRate",      [](const SummaryStatistics& s) { return s.completionRate; }},
+};
+
+/** KPIs the adaptive mode waits for */
+const char* const TRACKED[] = {"throughputPerMinute", "avgTimeInSystem", "maxQueueLength"};
+
+} // namespace
+
+Ensemble::Ensemble(const SimulationConfig& b, ThreadPool& p) : base(b), pool(p) {}
+
+void Ensemble::addReplicas(int count) {
+    int first = static_cast<int>(replicas.size());
+    replicas.resize(first + count);
+    sketches.resize(first + count);
+
+    // Every replica writes its own slot, so the result does not depend on scheduling
+    pool.parallelFor(count, [&](int i) {
+        SimulationConfig config = base;
+        config.seed = base.seed + static_cast<uint64_t>(first + i);
+        Simulation sim(config);
+        replicas[first + i] = sim.run();
+        sketches[first + i] = sim.getLogger().getDelaySketches();
+    });
+}
+
+DelaySketches Ensemble::mergedSketches() const {
+    DelaySketches merged;
+    for (const DelaySketches& replica : sketches)
+        merged.merge(replica);
+    return merged;
+}
+
+bool Ensemble::runUntil(double target, int maxReplicas) {
+    while (!converged(target)) {
+        int done = static_cast<int>(replicas.size());
+        if (done >= maxReplicas)
+            return false;
+        int batch = std::max(done < 2 ? 2 - done : 1, pool.size());
+        addReplicas(std::min(batch, maxReplicas - done));
+    }
+    return true;
+}
+
+bool Ensemble::converged(double target) const {
+    if (replicas.size() < 2)
+        return false;
+    for (const char* name : TRACKED) {
+        KpiEstimate est = estimate(name);
+        if (est.ciHalfWidth > target * std::fabs(est.mean))
+            return false;
+    }
+    return true;
+}
+
+KpiEstimate Ensemble::estimate(const std::string& metric) const {
+    for (const Kpi& kpi : KPIS) {
+        if (metric != kpi.name) continue;
+        std::vector<double> samples;
+        samples.reserve(replicas.size());
+        for (const SummaryStatistics& s : replicas)
+            samples.push_back(kpi.get(s));
+        return estimateKpi(samples);
+    }
+    return {};
+}
+
+void Ensemble::printTable() const {
+    std::cout << "\nEnsemble Statistics (" << replicas.size() << " replicas, seeds "
+              << base.seed << ".." << base.seed + replicas.size() - 1 << "):\n";
+    std::cout << std::string(84, '-') << std::endl;
+    std::cout << std::left << std::setw(24) << "Metric" << std::right << std::setw(12) << "Mean"
+              << std::setw(12) << "Stddev" << std::setw(12) << "CI95 +/-"
+              << std::setw(12) << "CI95 low" << std::setw(12) << "CI95 high" << std::endl;
+    std::cout << std::string(84, '-') << std::endl;
+    for (const Kpi& kpi : KPIS) {
+        KpiEstimate est = estimate(kpi.name);
+        std::cout << std::left << std::setw(24) << kpi.name << std::right << std::fixed << std::setprecision(4)
+                  << std::setw(12) << est.mean << std::setw(12) << est.stddev << std::setw(12) << est.ciHalfWidth
+                  << std::setw(12) << est.mean - est.ciHalfWidth << std::setw(12) << est.mean + est.ciHalfWidth
+                  << std::endl;
+    }
+    std::cout << std::string(84, '-') << std::endl << std::endl;
+}
+
+void Ensemble::exportAll(const std::string& directory) const {
+    std::filesystem::create_directories(directory);
+
+    std::string filename = directory + "/ensemble_statistics.csv";
+    std::ofstream file(filename);
+    if (!file) {
+        std::cerr << "Error: Cannot open file " << filename << std::endl;
+        return;
+    }
+    file << "metric,mean,stddev,ci95Low,ci95High,replicas\n" << std::fixed << std::setprecision(4);
+    for (const Kpi& kpi : KPIS) {
+        KpiEstimate est = estimate(kpi.name);
+        file << kpi.name << "," << est.mean << "," << est.stddev << ","
+             << est.mean - est.ciHalfWidth << "," << est.mean + est.ciHalfWidth << "," << est.samples << "\n";
+    }
+    file.close();
+    std::cout << "Exported ensemble statistics to: " << filename << std::endl;
+
+    filename = directory + "/replica_statistics.csv";
+    file.open(filename);
+    if (!file) {
+        std::cerr << "Error: Cannot open file " << filename << std::endl;
+        return;
+    }
+    file << "replica,seed,totalCarsSpawned,totalCarsExited";
+    for (const Kpi& kpi : KPIS)
+        file << "," << kpi.name;
+    file << "\n" << std::fixed << std::setprecision(4);
+    for (size_t i = 0; i < replicas.size(); i++) {
+        file << i << "," << base.seed + i << "," << replicas[i].totalCarsSpawned << "," << replicas[i].totalCarsExited;
+        for (const Kpi& kpi : KPIS)
+            file << "," << kpi.get(replicas[i]);
+        file << "\n";
+    }
+    file.close();
+    std::cout << "Exported replica statistics to: " << filename << std::endl;
+
+    Logger::exportDelayQuantiles(mergedSketches(), directory + "/delay_quantiles.csv");
+}
@@ -3,19 +3,18 @@
  * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
  */
 #include "Grid.hpp"
-#include <cstdlib>
 #include <fstream>
 #include <algorithm>
 #include "Utils.hpp"
 #include <cmath>
 #include <map>
 #include <iostream>
+#include <type_traits>
+#include "NaschKernel.hpp"
+#include "BinaryIO.hpp"
 
 Grid::Grid(int w, int h) : width(w), height(h) {
-    cells.resize(height, std::vector<Cell>(width));
-    for (int y = 0; y < height; y++)
-        for (int x = 0; x < width; x++)
-            cells[y][x] = Cell(); // empty
+    cells.assign(static_cast<size_t>(width) * height, Cell());
 }
 
 void Grid::initializeMap(double density, bool opt) {
@@ -46,9 +45,9 @@ void Grid::initializeMap(double density, bool opt) {
         int x = centerX - numLanesNorthIn + lane;
         if (x < 0 || x >= width) continue;
         // Set the edge road cell as spawn point for all cars coming from north
-        cells[0][x].setSpawnPoint(true);
+        cells[index(0, x)].setSpawnPoint(true);
         for (int y = 0; y < northHeight; y++)
-            cells[y][x].setAlive(true);
+            cells[index(y, x)].setAlive(true);
     }
 
     // North outbound: top side, cars going UP -> right of center (x > centerX)
@@ -56,7 +55,7 @@ void Grid::initializeMap(double density, bool opt) {
         int x = centerX + northLaneSpace + lane;
         if (x < 0 || x >= width) continue;
         for (int y = 0; y < northHeight; y++)
-            cells[y][x].setAlive(true);
+            cells[index(y, x)].setAlive(true);
     }
 
     // South inbound: bottom side, cars going UP -> right of center (x > centerX)
@@ -64,9 +63,9 @@ void Grid::initializeMap(double density, bool opt) {
         int x = centerX + lane;
         if (x < 0 || x >= width) continue;
         // Set the edge road cell as spawn point for all cars coming from south
-        cells[height - 1][x].setSpawnPoint(true);
+        cells[index(height - 1, x)].setSpawnPoint(true);
         for (int y = height - 1; y > southHeight; y--)
-            cells[y][x].setAlive(true);
+            cells[index(y, x)].setAlive(true);
     }
 
     // South outbound: bottom side, cars going DOWN -> left of center (x < centerX)
@@ -74,7 +73,7 @@ void Grid::initializeMap(double density, bool opt) {
         int x = centerX - numLanesSouthOut - southLaneSpace + lane;
         if (x < 0 || x >= width) continue;
         for (int y = height - 1; y > southHeight; y--)
-            cells[y][x].setAlive(true);
+            cells[index(y, x)].setAlive(true);
     }
 
     // HORIZONTAL ROADS (West-East)
@@ -83,9 +82,9 @@ void Grid::initializeMap(double density, bool opt) {
         int y = centerY + lane;
         if (y < 0 || y >= height) continue;
         // Set the edge road cell as spawn point for all cars coming from west
-        cells[y][0].setSpawnPoint(true);
+        cells[index(y, 0)].setSpawnPoint(true);
         for (int x = 0; x < westWidth; x++)
-            cells[y][x].setAlive(true);
+            cells[index(y, x)].setAlive(true);
     }
 
     // West outbound: left side, cars going LEFT -> above center (y < centerY)
@@ -93,7 +92,7 @@ void Grid::initializeMap(double density, bool opt) {
         int y = centerY - numLanesWestOut - westLaneSpace + lane;
         if (y < 0 || y >= height) continue;
         for (int x = 0; x < westWidth; x++)
-            cells[y][x].setAlive(true);
+            cells[index(y, x)].setAlive(true);
     }
 
     // East inbound: right side, cars going LEFT -> above center (y < centerY)
@@ -101,9 +100,9 @@ void Grid::initializeMap(double density, bool opt) {
         int y = centerY - numLanesEastIn - eastLaneSpace + lane;
         if (y < 0 || y >= width) continue;
         // Set the edge road cell as spawn point for all cars coming from east
-        cells[y][width - 1].setSpawnPoint(true);
+        cells[index(y, width - 1)].setSpawnPoint(true);
         for (int x = width - 1; x > eastWidth; x--)
-            cells[y][x].setAlive(true);
+            cells[index(y, x)].setAlive(true);
     }
 
     // East outbound: right side, cars going RIGHT -> below center (y > centerY)
@@ -111,7 +110,7 @@ void Grid::initializeMap(double density, bool opt) {
         int y = centerY + lane;
         if (y < 0 || y >= height) continue;
         for (int x = width - 1; x > eastWidth; x--)
-            cells[y][x].setAlive(true);
+            cells[index(y, x)].setAlive(true);
     }
 
     // Turn blocks at the junction
@@ -127,59 +126,61 @@ void Grid::initializeMap(double density, bool opt) {
     // Turns for cars coming from NORTH
     int y_northRight0 = northHeight - westLaneSpace;
     int x_northRight0 = centerX - northLaneSpace;
-    cells[y_northRight0][x_northRight0].setTurn(t3);
+    cells[index(y_northRight0, x_northRight0)].setTurn(t3);
 
     // Turns for cars coming from SOUTH
     int y_southLeft0 = southHeight;
     int x_southLeft0 = centerX;
     int y_southLeft1 = southHeight - eastLaneSpace;
     int x_southLeft1 = centerX + southLaneSpace;
-    cells[y_southLeft0][x_southLeft0].setTurn(t1);
-    cells[y_southLeft1][x_southLeft1].setTurn(t1);
+    cells[index(y_southLeft0, x_southLeft0)].setTurn(t1);
+    cells[index(y_southLeft1, x_southLeft1)].setTurn(t1);
 
     // Turns for cars coming from EAST
     int y_eastDown0 = centerY - westLaneSpace;
     int x_eastDown0 = eastWidth + northLaneSpace;
-    cells[y_eastDown0][x_eastDown0].setTurn(t2);
+    cells[index(y_eastDown0, x_eastDown0)].setTurn(t2);
+
+    compileLayout();
+}
+
+void Grid::setSignalPlan(const SignalPlan& plan) {
+    northInGreenDuration = plan.northGreen;
+    southInGreenDuration = plan.southGreen;
+    westInGreenDuration = plan.westGreen;
+    eastInStraightGreenDuration = plan.eastStraightGreen;
+    eastInTurnGreenDuration = plan.eastTurnGreen;
+}
+
+SignalPlan Grid::getSignalPlan() const {
+    return {northInGreenDuration, southInGreenDuration, westInGreenDuration,
+            eastInStraightGreenDuration, eastInTurnGreenDuration};
 }
 
 void Grid::setupCrossroadLights(int redDur, int yellowDur, int greenDur) {
     int centerX = width / 2;
     int centerY = height / 2;
 
-    int eastInStraightOnlyGreenDuration = eastInStraightGreenDuration - eastInTurnGreenDuration;
-    // Initialize red light durations
-    northInRedDuration = southInGreenDuration + eastInStraightGreenDuration +
-                        (westInGreenDuration > eastInStraightOnlyGreenDuration
-                            ? (westInGreenDuration - eastInStraightOnlyGreenDuration)
-                            : 0);
-    westInRedDuration = northInGreenDuration + southInGreenDuration + eastInTurnGreenDuration;
-    southInRedDuration = eastInStraightGreenDuration + northInGreenDuration +
-                        (westInGreenDuration > eastInStraightOnlyGreenDuration
-                            ? (westInGreenDuration - eastInStraightOnlyGreenDuration)
-                            : 0);
-    eastInStraightRedDuration = northInGreenDuration + southInGreenDuration +
-                                (westInGreenDuration > eastInStraightOnlyGreenDuration
-                                    ? (westInGreenDuration - eastInStraightOnlyGreenDuration)
-                                    : 0);
-    eastInTurnRedDuration = eastInStraightOnlyGreenDuration + northInGreenDuration + southInGreenDuration +
-                            (westInGreenDuration > eastInStraightOnlyGreenDuration
-                                ? (westInGreenDuration - eastInStraightOnlyGreenDuration)
-                                : 0);
+    // Phase order: east inbound (straight and left turn) -> west inbound once the left turn ends
+    // -> north inbound once east straight and west end -> south inbound
+    int northStart = std::max(eastInStraightGreenDuration, eastInTurnGreenDuration + westInGreenDuration);
+    int southStart = northStart + northInGreenDuration;
+    auto yellow = [](int green) { return static_cast<int>(green * 0.1); };
+
+    signals.clear();
+    int eastStraightGroup = signals.addGroup(0, eastInStraightGreenDuration, yellow(eastInStraightGreenDuration));
+    int eastTurnGroup = signals.addGroup(0, eastInTurnGreenDuration, yellow(eastInTurnGreenDuration));
+    int westGroup = signals.addGroup(eastInTurnGreenDuration, westInGreenDuration, yellow(westInGreenDuration));
+    int northGroup = signals.addGroup(northStart, northInGreenDuration, yellow(northInGreenDuration));
+    int southGroup = signals.addGroup(southStart, southInGreenDuration, yellow(southInGreenDuration));
+    signals.setCycle(southStart + southInGreenDuration);
 
     // Traffic lights for west inbound
     for (int lane = 0; lane < numLanesWestIn; lane++) {
         int x = centerX - numLanesNorthIn - northLaneSpace;
         int y = centerY + lane;
         if (x >= 0 && x < width && y >= 0 && y < height) {
-            TrafficLight tl;
-            tl.state = TrafficLight::RED;
-            tl.redDuration = westInRedDuration;
-            tl.yellowDuration = westInGreenDuration * 0.1;
-            tl.greenDuration = westInGreenDuration - tl.yellowDuration;
-            // Green once eastInTurnGreenDuration ends
-            tl.timer = tl.redDuration - eastInTurnGreenDuration;
-            cells[y][x].setTrafficLight(tl);
+            cells[index(y, x)].setSignalGroup(westGroup);
             // Create right turn lane
             if (lane == numLanesWestIn - 1) {
                 createRightTurnLanes(x, y, Direction::LEFT, distFromTrafficLight);
@@ -194,22 +195,10 @@ void Grid::setupCrossroadLights(int redDur, int yellowDur, int greenDur) {
         if (x >= 0 && x < width && y >= 0 && y < height) {
             // Set traffic light for left turn lane
             if (lane == numLanesEastIn - 1) {
-                TrafficLight tl;
-                tl.state = TrafficLight::GREEN;
-                tl.redDuration = eastInTurnRedDuration;
-                tl.yellowDuration = eastInTurnGreenDuration * 0.1;
-                tl.greenDuration = eastInTurnGreenDuration - tl.yellowDuration;
-                tl.timer = 0;
-                cells[y][x].setTrafficLight(tl);
+                cells[index(y, x)].setSignalGroup(eastTurnGroup);
                 continue;
             }
-            TrafficLight tl;
-            tl.state = TrafficLight::GREEN;
-            tl.redDuration = eastInStraightRedDuration;
-            tl.yellowDuration = eastInStraightGreenDuration * 0.1;
-            tl.greenDuration = eastInStraightGreenDuration - tl.yellowDuration;
-            tl.timer = 0;
-            cells[y][x].setTrafficLight(tl);
+            cells[index(y, x)].setSignalGroup(eastStraightGroup);
             // Create right turn lane
             if (lane == 0) {
                 createRightTurnLanes(x, y, Direction::RIGHT, distFromTrafficLight);
@@ -222,17 +211,7 @@ void Grid::setupCrossroadLights(int redDur, int yellowDur, int greenDur) {
         int y = centerY - numLanesEastIn - eastLaneSpace - 1;
         int x = centerX - lane - northLaneSpace;
         if (x >= 0 && x < width && y >= 0 && y < height) {
-            TrafficLight tl;
-            tl.state = TrafficLight::RED;
-            tl.redDuration = northInRedDuration;
-            tl.yellowDuration = northInGreenDuration * 0.1;
-            tl.greenDuration = northInGreenDuration - tl.yellowDuration;
-            // Green after eastInStraightGreenDuration or westInGreenDuration ends
-            tl.timer = tl.redDuration - eastInStraightGreenDuration -
-                        (westInGreenDuration > eastInStraightOnlyGreenDuration
-                            ? (westInGreenDuration - eastInStraightOnlyGreenDuration)
-                            : 0);
-            cells[y][x].setTrafficLight(tl);
+            cells[index(y, x)].setSignalGroup(northGroup);
             // Create right turn lane
             if (lane == numLanesNorthIn - 1) {
                 createRightTurnLanes(x, y, Direction::UP, distFromTrafficLight);
@@ -245,228 +224,523 @@ void Grid::setupCrossroadLights(int redDur, int yellowDur, int greenDur) {
         int y = centerY + numLanesWestIn;
         int x = centerX + numLanesSouthIn - lane - 1;
         if (x >= 0 && x < width && y >= 0 && y < height) {
-            TrafficLight tl;
-            tl.state = TrafficLight::RED;
-            tl.redDuration = southInRedDuration;
-            tl.yellowDuration = southInGreenDuration * 0.1;
-            tl.greenDuration = southInGreenDuration - tl.yellowDuration;
-            tl.timer = 0;
-            cells[y][x].setTrafficLight(tl);
+            cells[index(y, x)].setSignalGroup(southGroup);
             // Create right turn lane
             if (lane == 0) {
                 createRightTurnLanes(x, y, Direction::DOWN, distFromTrafficLight);
             }
         }
     }
+
+    compileLayout();
 }
 
-void Grid::update(const Rules& rules, double density, int vmax, double p, int step) {
-    std::vector<std::vector<Cell>> next(height, std::vector<Cell>(width, Cell()));
+void Grid::compileLayout() {
+    spawnCells.clear();
+    groupCells.assign(signals.getGroupCount(), {});
+    std::vector<std::pair<int, Direction>> entries;
+    for (int i = 0; i < static_cast<int>(cells.size()); i++) {
+        if (cells[i].isSpawnPoint()) {
+            spawnCells.push_back(i);
+            entries.push_back({i, getInitialDirection(i % width, i / width)});
+        }
+        int group = cells[i].getSignalGroup();
+        if (group >= 0 && group < signals.getGroupCount())
+            groupCells[group].push_back(i);
+    }
+    lanes.compile(cells, width, height, entries);
 
-    // Copy traffic lights and turns to next state
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
+    std::vector<char> road(cells.size(), 0);
+    for (const Lane& lane : lanes.getLanes()) {
+        for (int i : lane.cell)
+            road[i] = 1;
+    }
+    roadCells = static_cast<int>(std::count(road.begin(), road.end(), 1));
+    applySignals();
+}
 
-            if (cells[y][x].hasTrafficLight()) {
-                cells[y][x].updateTrafficLight();
-                next[y][x].setTrafficLight(*cells[y][x].getTrafficLight());
-            }
+void Grid::applySignals() {
+    for (int g = 0; g < signals.getGroupCount(); g++) {
+        for (int i : groupCells[g])
+            lanes.setRed(i, signals.getState(g) == SignalState::RED);
+    }
+}
 
-            if (cells[y][x].hasTurn()) {
-                next[y][x].setTurn(*cells[y][x].getTurn());
-            }
+void Grid::save(std::ostream& out) const {
+    // Layout is rebuilt from the configuration, only its size is stored to check it matches
+    BinaryIO::write(out, width);
+    BinaryIO::write(out, height);
+    BinaryIO::write(out, static_cast<int>(lanes.getLanes().size()));
+
+    BinaryIO::writeVector(out, vehicles);
+    BinaryIO::writeVector(out, freeSlots);
+    std::vector<int> ends;
+    for (const Lane& lane : lanes.getLanes()) {
+        ends.push_back(lane.front);
+        ends.push_back(lane.back);
+    }
+    BinaryIO::writeVector(out, ends);
 
-            if (cells[y][x].isSpawnPoint()) {
-                double willTurnProbability = calculateWillTurnProbability(x, y);
-                Direction dir = getInitialDirection(x, y);
-                double prob;
-
-                // Get per-lane spawnProbabilities
-                switch (dir) {
-                    case Direction::UP:    prob = southSpawnProb / numLanesSouthIn; break;
-                    case Direction::LEFT:  prob = eastSpawnProb / numLanesEastIn; break;
-                    case Direction::DOWN:  prob = northSpawnProb / numLanesNorthIn; break;
-                    case Direction::RIGHT: prob = westSpawnProb / numLanesWestIn; break;
-                    default:               prob = 0.0;
-                }
+    BinaryIO::write(out, nextCarId);
+    BinaryIO::write(out, currentCars);
+    BinaryIO::write(out, rng.getSeed());
+    BinaryIO::write(out, signals.getStep());
+}
 
-                double r = rand() / double(RAND_MAX);
+bool Grid::load(std::istream& in) {
+    int w = 0, h = 0, laneCount = 0;
+    if (!BinaryIO::read(in, w) || !BinaryIO::read(in, h) || !BinaryIO::read(in, laneCount))
+        return false;
+    if (w != width || h != height || laneCount != static_cast<int>(lanes.getLanes().size()))
+        return false;
+
+    std::vector<Vehicle> loaded;
+    std::vector<int> slots;
+    std::vector<int> ends;
+    int carId = 0, cars = 0, signalStep = 0;
+    uint64_t seed = 0;
+    if (!BinaryIO::readVector(in, loaded) || !BinaryIO::readVector(in, slots) || !BinaryIO::readVector(in, ends) ||
+        !BinaryIO::read(in, carId) || !BinaryIO::read(in, cars) || !BinaryIO::read(in, seed) ||
+        !BinaryIO::read(in, signalStep))
+        return false;
+    if (ends.size() != 2 * static_cast<size_t>(laneCount))
+        return false;
+    for (const Vehicle& vehicle : loaded) {
+        if (vehicle.active && (vehicle.lane < 0 || vehicle.lane >= laneCount || vehicle.pos < 0 ||
+                               vehicle.pos >= lanes.getLane(vehicle.lane).length))
+            return false;
+    }
 
-                if (currentCars < maxCars && r <= prob) {
-                    next[y][x].spawnCar(vmax, willTurnProbability, nextCarId++, dir);
+    // Drop current cars, then put the loaded ones back on their cells
+    for (const Vehicle& vehicle : vehicles) {
+        if (vehicle.active)
+            lanes.setOccupant({vehicle.lane, vehicle.pos}, -1);
+    }
+    vehicles = std::move(loaded);
+    freeSlots = std::move(slots);
+    for (int slot = 0; slot < static_cast<int>(vehicles.size()); slot++) {
+        if (vehicles[slot].active)
+            lanes.setOccupant({vehicles[slot].lane, vehicles[slot].pos}, slot);
+    }
+    for (int l = 0; l < laneCount; l++) {
+        lanes.getLane(l).front = ends[2 * l];
+        lanes.getLane(l).back = ends[2 * l + 1];
+    }
 
-                    if (logger) {
-                        bool willTurn = next[y][x].getCarWillTurn();
-                        logger->logVehicleSpawn(nextCarId, step, dir, willTurn);
-                    }
+    nextCarId = carId;
+    currentCars = cars;
+    rng.setSeed(seed);
+    signals.setStep(signalStep);
+    applySignals();
+    return true;
+}
 
-                    currentCars++;
-                }
+Car Grid::createCar(int vmax, double willTurnProb, int id, Direction dir, int step) const {
+    bool willTurn = false;
+    int velocity = rng.below(vmax + 1, step, id, RngStream::SpawnVelocity);
+    double r = rng.uniform(step, id, RngStream::SpawnTurn);
+    if (r < willTurnProb)
+        willTurn = true;
+    return Car{id, velocity, dir, willTurn};
+}
 
-                next[y][x].setSpawnPoint(true);
-            }
+int Grid::addVehicle(const Car& car, LanePos at) {
+    int slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else {
+        slot = static_cast<int>(vehicles.size());
+        vehicles.emplace_back();
+    }
+    vehicles[slot].car = car;
+    vehicles[slot].lane = at.lane;
+    vehicles[slot].pos = at.pos;
+    vehicles[slot].active = true;
+    lanes.setOccupant(at, slot);
+    linkVehicle(slot);
+    return slot;
+}
 
-            if (cells[y][x].isAlive()) {
-                next[y][x].setAlive(true);
-            }
-        }
+void Grid::removeVehicle(int slot) {
+    unlinkVehicle(slot);
+    vehicles[slot].active = false;
+    vehicles[slot].lane = -1;
+    vehicles[slot].pos = -1;
+    freeSlots.push_back(slot);
+}
+
+void Grid::linkVehicle(int slot) {
+    Vehicle& vehicle = vehicles[slot];
+    Lane& lane = lanes.getLane(vehicle.lane);
+
+    // Cars join near the back of a lane (spawn points, turn blocks), so search from there
+    int leader = lane.back;
+    int follower = -1;
+    while (leader >= 0 && vehicles[leader].pos < vehicle.pos) {
+        follower = leader;
+        leader = vehicles[leader].leader;
     }
 
-    // First pass: Calculate desired positions and velocities for all cars
-    struct CarMove {
-        int oldX, oldY;
-        int newX, newY;
-        int newVel;
-        int carId;
-        Direction dir;
-        bool willTurn;
-    };
+    vehicle.leader = leader;
+    vehicle.follower = follower;
+    if (leader >= 0) vehicles[leader].follower = slot;
+    else lane.front = slot;
+    if (follower >= 0) vehicles[follower].leader = slot;
+    else lane.back = slot;
+}
 
-    std::vector<CarMove> moves;
+void Grid::unlinkVehicle(int slot) {
+    Vehicle& vehicle = vehicles[slot];
+    Lane& lane = lanes.getLane(vehicle.lane);
 
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
+    // Turning cars are off every list until they join their new lane
+    if (vehicle.leader < 0 && vehicle.follower < 0 && lane.front != slot)
+        return;
 
-            if (!cells[y][x].hasCar()) continue;
+    if (vehicle.leader >= 0) vehicles[vehicle.leader].follower = vehicle.follower;
+    else lane.front = vehicle.follower;
+    if (vehicle.follower >= 0) vehicles[vehicle.follower].leader = vehicle.leader;
+    else lane.back = vehicle.leader;
+    vehicle.leader = -1;
+    vehicle.follower = -1;
+}
 
-            Direction dir = cells[y][x].getCarDirection();
-            int dx = 0, dy = 0;
+void Grid::forEachLane(const std::function<void(int)>& fn) {
+    int laneCount = static_cast<int>(lanes.getLanes().size());
+    if (pool) {
+        pool->parallelFor(laneCount, fn);
+        return;
+    }
+    for (int l = 0; l < laneCount; l++)
+        fn(l);
+}
 
-            if (dir == Direction::RIGHT)      { dx = 1;  dy = 0; }
-            else if (dir == Direction::LEFT)  { dx = -1; dy = 0; }
-            else if (dir == Direction::UP)    { dx = 0;  dy = -1; }
-            else if (dir == Direction::DOWN)  { dx = 0;  dy = 1; }
+void Grid::allocateBatches() {
+    // A lane never holds more cars than it has cells
+    batches.resize(lanes.getLanes().size());
+    for (size_t l = 0; l < batches.size(); l++) {
+        size_t length = lanes.getLane(static_cast<int>(l)).length;
+        batches[l].vel.assign(length, 0);
+        batches[l].gap.assign(length, 0);
+        batches[l].brake.assign(length, 0);
+    }
+}
 
-            // Logging update
-            cells[y][x].updateTotalVelocity();
+template <class R, int VMax>
+void Grid::planLane(int l, const R& rules, int vmax, double p, int step) {
+    // A compile-time speed limit lets the compiler fold the clamps and the gap limit
+    if constexpr (VMax > 0)
+        vmax = VMax;
+
+    // Lane cars in front to back order, the planned velocities are left in batch.vel for moveLane
+    VelocityBatch& batch = batches[l];
+    int n = 0;
+    if constexpr (std::is_same_v<R, NSRules>) {
+        // Gather the lane into contiguous arrays and run the SIMD kernel over all of its cars
+        for (int slot = lanes.getLane(l).front; slot >= 0; slot = vehicles[slot].follower, n++) {
+            const Vehicle& vehicle = vehicles[slot];
+            double r = rng.uniform(step, vehicle.car.id, RngStream::Braking);
+            batch.vel[n] = static_cast<int16_t>(vehicle.car.velocity);
+            batch.gap[n] = static_cast<int16_t>(gapAhead(vehicle, vmax + 1));
+            batch.brake[n] = r < p;
+        }
+        NaschKernel::apply(batch.vel.data(), batch.gap.data(), batch.brake.data(), n, vmax);
+    } else {
+        for (int slot = lanes.getLane(l).front; slot >= 0; slot = vehicles[slot].follower, n++) {
+            const Vehicle& vehicle = vehicles[slot];
 
-            int currentVel = cells[y][x].getCarVelocity();
-            int dist = distanceToNextCar(x, y);
+            // NaSch never looks further than vmax + 1 cells ahead
+            int dist = gapAhead(vehicle, vmax + 1);
 
             // Apply NaSch rules
-            int newVel = rules.nextVelocity(currentVel, dist, vmax, p);
+            double r = rng.uniform(step, vehicle.car.id, RngStream::Braking);
+            batch.vel[n] = static_cast<int16_t>(rules.nextVelocity(vehicle.car.velocity, dist, vmax, p, r));
+        }
+    }
+}
+
+template <bool Logged>
+void Grid::moveLane(int l) {
+    Lane& lane = lanes.getLane(l);
+    std::vector<int>& deferred = deferredMoves[l];
+    deferred.clear();
+
+    const std::vector<int16_t>& planned = batches[l].vel;
+    LaneTally tally;
+
+    // Front to back, so a leader always leaves its cell before the follower can take it
+    int i = 0;
+    for (int slot = lane.front; slot >= 0; slot = vehicles[slot].follower, i++) {
+        Vehicle& vehicle = vehicles[slot];
+        vehicle.newVelocity = planned[i];
+        int newPos = vehicle.pos + vehicle.newVelocity;
+
+        // Cells outside crossings belong to this lane only, crossing cells are left to the serial pass
+        bool leavesShared = lane.flags[vehicle.pos] & Lane::SHARED;
+        if (!leavesShared)
+            lane.place(vehicle.pos, -1);
+
+        bool turns = newPos < lane.length && (lane.flags[newPos] & Lane::TURN) && vehicle.car.willTurn &&
+                     lanes.findLink(l, newPos);
+
+        // Stopped cars keep their position, so queues are complete before any car is placed
+        if constexpr (Logged) {
+            if (vehicle.newVelocity == 0) {
+                if (turns) tally.stale = true;
+                else tally.queue(newPos);
+            }
+        }
+
+        bool local = !leavesShared && newPos < lane.length && !(lane.flags[newPos] & Lane::SHARED) && !turns;
+        if (!local) {
+            deferred.push_back(slot);
+            continue;
+        }
+
+        lane.place(newPos, slot);
+        vehicle.pos = newPos;
+        vehicle.car.velocity = vehicle.newVelocity;
+        if constexpr (Logged)
+            tally.add(lane, newPos, vehicle.newVelocity);
+    }
+
+    if constexpr (Logged)
+        laneTallies[l] = tally;
+}
+
+void Grid::recountStaleQueues() {
+    for (int l = 0; l < static_cast<int>(laneTallies.size()); l++) {
+        LaneTally& tally = laneTallies[l];
+        if (!tally.stale)
+            continue;
+        tally.maxQueue = 0;
+        tally.runEnd = -2;
+        for (int slot = lanes.getLane(l).front; slot >= 0; slot = vehicles[slot].follower) {
+            if (vehicles[slot].car.velocity == 0)
+                tally.queue(vehicles[slot].pos);
+        }
+        tally.stale = false;
+    }
+}
 
-            // Calculate new position
-            int newX = x;
-            int newY = y;
+template <class R, int VMax, bool Logged>
+void Grid::update(const R& rules, double density, int vmax, double p, int step) {
+    // Static layout stays in place, only stop lines of groups that changed light are mirrored into the lane red masks
+    if (signals.advance()) {
+        for (int g : signals.getChanged()) {
+            bool red = signals.getState(g) == SignalState::RED;
+            for (int i : groupCells[g])
+                lanes.setRed(i, red);
+        }
+    }
+
+    // First pass (parallel per lane): Calculate new velocities of all cars on a fixed snapshot of the lanes
+    if (batches.size() != lanes.getLanes().size())
+        allocateBatches();
+    forEachLane([&](int l) { planLane<R, VMax>(l, rules, vmax, p, step); });
+
+    applyMoves<Logged>(vmax, step);
+}
+
+template void Grid::update<Rules, 0>(const Rules&, double, int, double, int);
+template void Grid::update<NSRules, 0>(const NSRules&, double, int, double, int);
+template void Grid::update<NSRules, 3>(const NSRules&, double, int, double, int);
+template void Grid::update<NSRules, 5>(const NSRules&, double, int, double, int);
+template void Grid::update<NSRules, 0, false>(const NSRules&, double, int, double, int);
+template void Grid::update<NSRules, 3, false>(const NSRules&, double, int, double, int);
+template void Grid::update<NSRules, 5, false>(const NSRules&, double, int, double, int);
+
+template <bool Logged>
+void Grid::applyMoves(int vmax, int step) {
+    int laneCount = static_cast<int>(lanes.getLanes().size());
+    deferredMoves.resize(laneCount);
+    if constexpr (Logged)
+        laneTallies.resize(laneCount);
+
+    // Second pass (parallel per lane): Move cars that stay on their lane outside of crossing cells
+    forEachLane([&](int l) { moveLane<Logged>(l); });
+
+    // Third pass (serial, fixed lane order): Lift remaining cars off crossing cells
+    for (int l = 0; l < laneCount; l++) {
+        const Lane& lane = lanes.getLane(l);
+        for (int slot : deferredMoves[l]) {
+            const Vehicle& vehicle = vehicles[slot];
+            if (lane.flags[vehicle.pos] & Lane::SHARED)
+                lanes.setOccupant({l, vehicle.pos}, -1);
+        }
+    }
 
-            if (dx != 0) newX = x + newVel * dx;
-            if (dy != 0) newY = y + newVel * dy;
+    // Fourth pass (serial, fixed lane order): Put remaining cars on their new positions
+    // (turning cars join their new lane once all positions are final)
+    std::vector<int> turned;
+    for (int l = 0; l < laneCount; l++) {
+        for (int slot : deferredMoves[l]) {
+            Vehicle& vehicle = vehicles[slot];
+            const Lane& lane = lanes.getLane(vehicle.lane);
+            int newVel = vehicle.newVelocity;
+            int newPos = vehicle.pos + newVel;
 
             // Remove car if it leaves the grid
-            if (newX >= width || newX < 0 || newY >= height || newY < 0) {
-                int carId = cells[y][x].getCarId();
-                cells[y][x].removeCar();
+            if (newPos >= lane.length) {
+                removeVehicle(slot);
                 currentCars--;
 
-                if (logger) {
-                    logger->logVehicleExit(carId, step);
+                if constexpr (Logged) {
+                    if (logger)
+                        logger->logVehicleExit(slot, step);
                 }
 
                 continue;
             }
 
-            moves.push_back({
-                x, y, newX, newY,
-                newVel,
-                cells[y][x].getCarId(),
-                dir,
-                cells[y][x].getCarWillTurn()
-            });
+            LanePos dest{vehicle.lane, newPos};
+            if ((lane.flags[newPos] & Lane::TURN) && vehicle.car.willTurn) {
+                const LaneLink* link = lanes.findLink(vehicle.lane, newPos);
+                if (link) {
+                    dest = link->to;
+                    unlinkVehicle(slot);
+                    turned.push_back(slot);
+                }
+            }
+
+            int other = lanes.getOccupant(dest);
+            if (other >= 0) {
+                // Two cars claimed the same cell (merging lanes), the earlier one is lost
+                auto pending = std::find(turned.begin(), turned.end(), other);
+                if (pending != turned.end())
+                    turned.erase(pending);
+                if constexpr (Logged) {
+                    // The lost car was placed earlier in this step
+                    const Vehicle& lost = vehicles[other];
+                    LaneTally& tally = laneTallies[lost.lane];
+                    tally.add(lanes.getLane(lost.lane), lost.pos, lost.car.velocity, -1);
+                    tally.stale |= lost.car.velocity == 0;
+                }
+                removeVehicle(other);
+                currentCars--;
+
+                if constexpr (Logged) {
+                    if (logger)
+                        logger->logVehicleLost(other, step);
+                }
+            }
+
+            lanes.setOccupant(dest, slot);
+            if constexpr (Logged) {
+                LaneTally& tally = laneTallies[dest.lane];
+                tally.add(lanes.getLane(dest.lane), dest.pos, newVel);
+                tally.stale |= newVel == 0 && dest.lane != vehicle.lane;
+            }
+            vehicle.lane = dest.lane;
+            vehicle.pos = dest.pos;
+            vehicle.car.direction = lanes.getLane(dest.lane).dir;
+            vehicle.car.velocity = newVel;
         }
     }
 
-    // Second pass: Apply moves
-    for (const auto& move : moves) {
-        bool turn = cells[move.oldY][move.oldX].getCarWillTurn();
-        cells[move.oldY][move.oldX].moveCarTo(next[move.newY][move.newX]);
-
-        if (next[move.newY][move.newX].hasTurn() && turn) {
-            next[move.newY][move.newX].setCarDirection(
-                next[move.newY][move.newX].getTurnDirection()
-            );
+    for (int slot : turned)
+        linkVehicle(slot);
+
+    // Spawn new cars on entry cells that are free after the moves
+    for (int i : spawnCells) {
+        int x = i % width;
+        int y = i / width;
+        double willTurnProbability = calculateWillTurnProbability(x, y);
+        Direction dir = getInitialDirection(x, y);
+        double prob;
+
+        // Get per-lane spawnProbabilities
+        switch (dir) {
+            case Direction::UP:    prob = southSpawnProb / numLanesSouthIn; break;
+            case Direction::LEFT:  prob = eastSpawnProb / numLanesEastIn; break;
+            case Direction::DOWN:  prob = northSpawnProb / numLanesNorthIn; break;
+            case Direction::RIGHT: prob = westSpawnProb / numLanesWestIn; break;
+            default:               prob = 0.0;
         }
+        prob *= inflowScale;
+
+        double r = rng.uniform(step, i, RngStream::Spawn);
+
+        LanePos entry = lanes.locate(x, y, dir);
+        if (currentCars < maxCars && r < prob && lanes.getOccupant(entry) < 0) {
+            Car car = createCar(vmax, willTurnProbability, nextCarId++, dir, step);
+            int slot = addVehicle(car, entry);
+
+            if constexpr (Logged) {
+                // New cars join behind the queues fed so far unless the entry is not the lane back
+                LaneTally& tally = laneTallies[entry.lane];
+                tally.add(lanes.getLane(entry.lane), entry.pos, car.velocity);
+                if (car.velocity == 0) {
+                    if (lanes.getLane(entry.lane).back == slot) tally.queue(entry.pos);
+                    else tally.stale = true;
+                }
+                if (logger)
+                    logger->logVehicleSpawn(slot, car.id, step, dir, car.willTurn);
+            }
 
-        next[move.newY][move.newX].setCarVelocity(move.newVel);
+            currentCars++;
+        }
     }
 
-    cells = std::move(next);
-
-    // Logging
-    if (logger) {
+    // Logging (compiled out without Logged)
+    if constexpr (Logged) {
+        if (!logger)
+            return;
+        recountStaleQueues();
         TimestepMetrics metrics = collectTimestepMetrics(step);
         logger->logTimestep(metrics);
 
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                if (cells[y][x].hasCar()) {
-                    int vel = cells[y][x].getCarVelocity();
-                    logger->logVehicleState(cells[y][x].getCarId(), step, x, y, vel);
-                    logger->logSpatialData(x, y, vel);
-                }
-            }
+        // Only vehicles in the sample are followed, the heatmap is observed on recorded steps
+        bool spatial = logger->isSpatialStep(step);
+        if (!spatial && !logger->tracksVehicles())
+            return;
+        for (int slot = 0; slot < static_cast<int>(vehicles.size()); slot++) {
+            const Vehicle& vehicle = vehicles[slot];
+            if (!vehicle.active) continue;
+            bool tracked = logger->isTracked(slot);
+            if (!tracked && !spatial) continue;
+            int cell = cellOf(vehicle);
+            int x = cell % width;
+            int y = cell / width;
+            if (tracked)
+                logger->logVehicleState(slot, step, x, y, vehicle.car.velocity);
+            if (spatial)
+                logger->logSpatialData(x, y, vehicle.car.velocity);
         }
     }
 }
 
 int Grid::distanceToNextCar(int x, int y) const {
-    if (!cells[y][x].hasCar()) return 0;
-  
-    Direction dir = cells[y][x].getCarDirection();
-    int dx = 0, dy = 0;
-    int loop_size = 0;
-    if (dir == Direction::RIGHT || dir == Direction::LEFT) {
-        loop_size = width;
-        dx = (dir == Direction::RIGHT) ? 1 : -1;
-    } else if (dir == Direction::UP || dir == Direction::DOWN) {
-        loop_size = height;
-        dy = (dir == Direction::DOWN) ? 1 : -1;
-    }
-  
-    int dist = 1;
-    int cx = x;
-    int cy = y;
-  
-    while (dist < loop_size) {
-        cx = cx + dx;
-        cy = cy + dy;
-
-        if (cx >= width || cx < 0 || cy >= height || cy < 0) {
-            // Out of bounds
-            return dx != 0 ? width : height;
-        }
-      
-        // Check for red traffic light
-        if (cells[cy][cx].hasTrafficLight()) {
-            if (cells[cy][cx].getTrafficLightState() == TrafficLight::RED) {
-                return dist;
-            }
-        }
-      
-        // Check for another car
-        if (cells[cy][cx].hasCar()) {
-            return dist;
-        }
+    int slot = lanes.occupantAt(x, y);
+    if (slot < 0) return 0;
+    const Vehicle& vehicle = vehicles[slot];
+    return gapAhead(vehicle, lanes.getLane(vehicle.lane).clearDistance);
+}
 
-        if (cells[cy][cx].hasTurn() && cells[y][x].getCarWillTurn()) {
-            return dist + 1;
-        }
-      
-        dist++;
-    }
-    return loop_size;
+int Grid::gapAhead(const Vehicle& vehicle, int limit) const {
+    const Lane& lane = lanes.getLane(vehicle.lane);
+    int pos = vehicle.pos;
+
+    // Free road up to the grid edge
+    int gap = std::min(lane.clearDistance, limit);
+
+    // Turn block (the car may stop on it)
+    if (vehicle.car.willTurn && lane.nextTurn[pos] < gap)
+        gap = std::min(gap, lane.nextTurn[pos] + 1);
+
+    // Next car on the same lane, car of a crossing lane or red traffic light
+    return lane.firstBlocked(pos, gap);
 }
 
 double Grid::averageVelocity() const {
     int totalVel = 0;
     int carCount = 0;
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            if (cells[y][x].hasCar()) {
-                totalVel += cells[y][x].getCarVelocity();
-                carCount++;
-            }
-        }
+    for (const Vehicle& vehicle : vehicles) {
+        if (!vehicle.active) continue;
+        totalVel += vehicle.car.velocity;
+        carCount++;
     }
     return carCount > 0 ? (double)totalVel / carCount : 0.0;
 }
@@ -544,23 +818,23 @@ void Grid::createRightTurnLanes(int x, int y, Direction fromDir, int distFromTra
         int newY = y - distFromTrafficLight;
         if (newX < 0 || newY < 0) return;
         // 1st turn block
-        cells[newY][x].setTurn(t0);
+        cells[index(newY, x)].setTurn(t0);
 
         // Create seperate lane for right turn (horizontal part)
         for (int i = 0; i <= distFromTrafficLight; i++) {
             if (i == distFromTrafficLight) {
-                cells[newY][x - i].setTurn(t1);
+                cells[index(newY, x - i)].setTurn(t1);
                 continue;
             }
-            cells[newY][x - i].setAlive(true);
+            cells[index(newY, x - i)].setAlive(true);
         }
         // Create vertical part of the right turn lane
         for (int i = 0; i <= distFromTrafficLight + 1; i++) {
             if (i == distFromTrafficLight + 1) {
-                cells[newY + i][newX].setTurn(t0);
+                cells[index(newY + i, newX)].setTurn(t0);
                 continue;
             }
-            cells[newY + i][newX].setAlive(true);
+            cells[index(newY + i, newX)].setAlive(true);
         }
     }
     // Create right turn lane for south inbound
@@ -569,23 +843,23 @@ void Grid::createRightTurnLanes(int x, int y, Direction fromDir, int distFromTra
         int newY = y + distFromTrafficLight;
         if (newX < 0 || newY < 0) return;
         // 1st turn block
-        cells[newY][x].setTurn(t2);
+        cells[index(newY, x)].setTurn(t2);
 
         // Create seperate lane for right turn (horizontal part)
         for (int i = 0; i <= distFromTrafficLight; i++) {
             if (i == distFromTrafficLight) {
-                cells[newY][x + i].setTurn(t3);
+                cells[index(newY, x + i)].setTurn(t3);
                 continue;
             }
-            cells[newY][x + i].setAlive(true);
+            cells[index(newY, x + i)].setAlive(true);
         }
         // Create vertical part of the right turn lane
         for (int i = 0; i <= distFromTrafficLight + 1; i++) {
             if (i == distFromTrafficLight + 1) {
-                cells[newY - i][newX].setTurn(t2);
+                cells[index(newY - i, newX)].setTurn(t2);
                 continue;
             }
-            cells[newY - i][newX].setAlive(true);
+            cells[index(newY - i, newX)].setAlive(true);
         }
     }
     // Create right turn lane for west inbound
@@ -594,23 +868,23 @@ void Grid::createRightTurnLanes(int x, int y, Direction fromDir, int distFromTra
         int newY = y + distFromTrafficLight;
         if (newX < 0 || newY < 0) return;
         // 1st turn block
-        cells[y][newX].setTurn(t1);
+        cells[index(y, newX)].setTurn(t1);
 
         // Create seperate lane for right turn (vertical part)
         for (int i = 0; i <= distFromTrafficLight; i++) {
             if (i == distFromTrafficLight) {
-                cells[y + i][newX].setTurn(t2);
+                cells[index(y + i, newX)].setTurn(t2);
                 continue;
             }
-            cells[y + i][newX].setAlive(true);
+            cells[index(y + i, newX)].setAlive(true);
         }
         // Create horizontal part of the right turn lane
         for (int i = 0; i <= distFromTrafficLight + 1; i++) {
             if (i == distFromTrafficLight + 1) {
-                cells[newY][newX + i].setTurn(t1);
+                cells[index(newY, newX + i)].setTurn(t1);
                 continue;
             }
-            cells[newY][newX + i].setAlive(true);
+            cells[index(newY, newX + i)].setAlive(true);
         }
     }
     // Create right turn lane for east inbound
@@ -619,23 +893,23 @@ void Grid::createRightTurnLanes(int x, int y, Direction fromDir, int distFromTra
         int newY = y - distFromTrafficLight;
         if (newX < 0 || newY < 0) return;
         // 1st turn block
-        cells[y][newX].setTurn(t3);
+        cells[index(y, newX)].setTurn(t3);
 
         // Create seperate lane for right turn (vertical part)
         for (int i = 0; i <= distFromTrafficLight; i++) {
             if (i == distFromTrafficLight) {
-                cells[y - i][newX].setTurn(t0);
+                cells[index(y - i, newX)].setTurn(t0);
                 continue;
             }
-            cells[y - i][newX].setAlive(true);
+            cells[index(y - i, newX)].setAlive(true);
         }
         // Create horizontal part of the right turn lane
         for (int i = 0; i <= distFromTrafficLight + 1; i++) {
             if (i == distFromTrafficLight + 1) {
-                cells[newY][newX - i].setTurn(t3);
+                cells[index(newY, newX - i)].setTurn(t3);
                 continue;
             }
-            cells[newY][newX - i].setAlive(true);
+            cells[index(newY, newX - i)].setAlive(true);
         }
     }
 }
@@ -647,7 +921,7 @@ TimestepMetrics Grid::collectTimestepMetrics(int currentStep) {
     metrics.carsEntered = nextCarId;
     metrics.carsExited = nextCarId - currentCars;
     
-    // Calculate velocities and counts
+    // Sum the lane tallies per direction
     int totalVel = 0, carCount = 0;
     int velNorth = 0, cntNorth = 0;
     int velSouth = 0, cntSouth = 0;
@@ -655,35 +929,30 @@ TimestepMetrics Grid::collectTimestepMetrics(int currentStep) {
     int velWest = 0, cntWest = 0;
     int stoppedCars = 0;
     int carsAtRedLight = 0;
-    
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            if (cells[y][x].hasCar()) {
-                int vel = cells[y][x].getCarVelocity();
-                Direction dir = cells[y][x].getCarDirection();
-                
-                totalVel += vel;
-                carCount++;
-                
-                if (vel == 0) stoppedCars++;
-                
-                // Check if at red light
-                if (cells[y][x].hasTrafficLight() && 
-                    cells[y][x].getTrafficLightState() == TrafficLight::RED) {
-                    carsAtRedLight++;
-                }
-                
-                // Direction-based metrics
-                if (dir == Direction::DOWN) {
-                    velNorth += vel; cntNorth++;
-                } else if (dir == Direction::UP) {
-                    velSouth += vel; cntSouth++;
-                } else if (dir == Direction::LEFT) {
-                    velEast += vel; cntEast++;
-                } else if (dir == Direction::RIGHT) {
-                    velWest += vel; cntWest++;
-                }
-            }
+    int queueNorth = 0, queueSouth = 0, queueEast = 0, queueWest = 0;
+
+    for (int l = 0; l < static_cast<int>(laneTallies.size()); l++) {
+        const LaneTally& tally = laneTallies[l];
+        Direction dir = lanes.getLane(l).dir;
+
+        totalVel += tally.velocitySum;
+        carCount += tally.cars;
+        stoppedCars += tally.stopped;
+        carsAtRedLight += tally.atRed;
+
+        // Direction-based metrics
+        if (dir == Direction::DOWN) {
+            velNorth += tally.velocitySum; cntNorth += tally.cars;
+            queueNorth = std::max(queueNorth, tally.maxQueue);
+        } else if (dir == Direction::UP) {
+            velSouth += tally.velocitySum; cntSouth += tally.cars;
+            queueSouth = std::max(queueSouth, tally.maxQueue);
+        } else if (dir == Direction::LEFT) {
+            velEast += tally.velocitySum; cntEast += tally.cars;
+            queueEast = std::max(queueEast, tally.maxQueue);
+        } else if (dir == Direction::RIGHT) {
+            velWest += tally.velocitySum; cntWest += tally.cars;
+            queueWest = std::max(queueWest, tally.maxQueue);
         }
     }
     
@@ -694,12 +963,10 @@ TimestepMetrics Grid::collectTimestepMetrics(int currentStep) {
     metrics.avgVelocityWest = cntWest > 0 ? (double)velWest / cntWest : 0.0;
     metrics.carsAtZeroVelocity = stoppedCars;
     metrics.carsWaitingAtRedLight = carsAtRedLight;
-    
-    // Calculate queue lengths
-    metrics.maxQueueNorth = calculateMaxQueue(Direction::DOWN);
-    metrics.maxQueueSouth = calculateMaxQueue(Direction::UP);
-    metrics.maxQueueEast = calculateMaxQueue(Direction::LEFT);
-    metrics.maxQueueWest = calculateMaxQueue(Direction::RIGHT);
+    metrics.maxQueueNorth = queueNorth;
+    metrics.maxQueueSouth = queueSouth;
+    metrics.maxQueueEast = queueEast;
+    metrics.maxQueueWest = queueWest;
     
     // These require tracking over time
     metrics.avgTimeInSystem = 0.0;  // Computed by Logger from vehicle data
@@ -709,39 +976,32 @@ TimestepMetrics Grid::collectTimestepMetrics(int currentStep) {
 }
 
 int Grid::calculateMaxQueue(Direction dir) {
+    // Queues are runs of stopped cars along columns (vertical) or rows (horizontal)
+    bool vertical = (dir == Direction::DOWN || dir == Direction::UP);
+    int dx = vertical ? 0 : 1;
+    int dy = vertical ? 1 : 0;
+    auto isQueued = [&](int x, int y) {
+        int slot = lanes.occupantAt(x, y);
+        return slot >= 0 && vehicles[slot].car.direction == dir && vehicles[slot].car.velocity == 0;
+    };
+
     int maxQueue = 0;
-    int currentQueue = 0;
-    
-    if (dir == Direction::DOWN || dir == Direction::UP) {
-        // Vertical lanes
-        for (int x = 0; x < width; x++) {
-            currentQueue = 0;
-            for (int y = 0; y < height; y++) {
-                if (cells[y][x].hasCar() && 
-                    cells[y][x].getCarDirection() == dir && 
-                    cells[y][x].getCarVelocity() == 0) {
-                    currentQueue++;
-                    maxQueue = std::max(maxQueue, currentQueue);
-                } else {
-                    currentQueue = 0;
-                }
-            }
-        }
-    } else {
-        // Horizontal lanes
-        for (int y = 0; y < height; y++) {
-            currentQueue = 0;
-            for (int x = 0; x < width; x++) {
-                if (cells[y][x].hasCar() && 
-                    cells[y][x].getCarDirection() == dir && 
-                    cells[y][x].getCarVelocity() == 0) {
-                    currentQueue++;
-                    maxQueue = std::max(maxQueue, currentQueue);
-                } else {
-                    currentQueue = 0;
-                }
-            }
+    for (const Vehicle& vehicle : vehicles) {
+        if (!vehicle.active || vehicle.car.direction != dir || vehicle.car.velocity != 0) continue;
+
+        int x = cellOf(vehicle) % width;
+        int y = cellOf(vehicle) / width;
+
+        // Count each run once, starting from its first car in scan order
+        if (isQueued(x - dx, y - dy)) continue;
+
+        int currentQueue = 0;
+        while (isQueued(x, y)) {
+            currentQueue++;
+            x += dx;
+            y += dy;
         }
+        maxQueue = std::max(maxQueue, currentQueue);
     }
     
     return maxQueue;
@@ -750,38 +1010,25 @@ int Grid::calculateMaxQueue(Direction dir) {
 void Grid::logDirectionMetrics(int currentStep) {
     if (!logger) return;
     
-    // Calculate metrics for each direction
-    std::map<Direction, DirectionMetrics> dirMetrics;
-    
-    for (const auto& [id, traj] : logger->vehicleData) {
-        Direction dir = traj.spawnDirection;
-        if (dirMetrics.find(dir) == dirMetrics.end()) {
-            DirectionMetrics dm;
-            dm.dir = dir;
-            dm.totalVehicles = 0;
-            dm.vehiclesExited = 0;
-            dm.avgSpeed = 0.0;
-            dm.maxQueue = 0;
-            dm.avgWaitTime = 0.0;
-            dm.throughputRate = 0.0;
-            dirMetrics[dir] = dm;
-        }
-        
-        dirMetrics[dir].totalVehicles++;
-        if (traj.exitStep > 0) {
-            dirMetrics[dir].vehiclesExited++;
-            dirMetrics[dir].avgSpeed += traj.avgVelocity;
-            dirMetrics[dir].avgWaitTime += traj.stepsAtZeroVelocity;
+    // Calculate metrics for each direction vehicles were spawned on
+    for (Direction dir : {LEFT, RIGHT, UP, DOWN}) {
+        VehicleTotals totals = logger->getVehicleTotals(dir);
+        if (totals.vehicles == 0)
+            continue;
+
+        DirectionMetrics dm;
+        dm.dir = dir;
+        dm.totalVehicles = totals.vehicles;
+        dm.vehiclesExited = totals.exited;
+        dm.avgSpeed = 0.0;
+        dm.avgWaitTime = 0.0;
+        dm.throughputRate = 0.0;
+        if (totals.sampledExited > 0) {
+            dm.avgSpeed = totals.velocitySum / totals.sampledExited;
+            dm.avgWaitTime = static_cast<double>(totals.stoppedSum) / totals.sampledExited;
         }
-    }
-    
-    // Finalize calculations
-    for (auto& [dir, dm] : dirMetrics) {
-        if (dm.vehiclesExited > 0) {
-            dm.avgSpeed /= dm.vehiclesExited;
-            dm.avgWaitTime /= dm.vehiclesExited;
+        if (dm.vehiclesExited > 0)
             dm.throughputRate = (dm.vehiclesExited * 60.0) / currentStep;
-        }
         dm.maxQueue = calculateMaxQueue(dir);
         logger->logDirectionMetrics(dm);
     }
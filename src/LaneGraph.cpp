@@ -0,0 +1,173 @@
+/**
+ * @file LaneGraph.cpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#include "LaneGraph.hpp"
+#include <algorithm>
+#include <climits>
+
+static bool isHorizontal(Direction dir) {
+    return dir == Direction::LEFT || dir == Direction::RIGHT;
+}
+
+int LaneGraph::progress(int x, int y, Direction dir) const {
+    switch (dir) {
+        case Direction::RIGHT: return x;
+        case Direction::LEFT:  return width - 1 - x;
+        case Direction::DOWN:  return y;
+        case Direction::UP:    return height - 1 - y;
+    }
+    return 0;
+}
+
+void LaneGraph::compile(const std::vector<Cell>& cells, int w, int h,
+                        const std::vector<std::pair<int, Direction>>& entries) {
+    width = w;
+    height = h;
+    lanes.clear();
+
+    // Cars enter lanes at spawn points and at turn blocks
+    std::vector<std::pair<int, Direction>> starts = entries;
+    for (int i = 0; i < static_cast<int>(cells.size()); i++) {
+        if (cells[i].hasTurn())
+            starts.push_back({i, cells[i].getTurnDirection()});
+    }
+
+    // A lane covers its row/column from the earliest entry up to the grid edge
+    std::array<std::vector<int>, 4> first;
+    for (int d = 0; d < 4; d++) {
+        int lines = isHorizontal(static_cast<Direction>(d)) ? height : width;
+        first[d].assign(lines, INT_MAX);
+        laneByLine[d].assign(lines, -1);
+    }
+    for (const auto& [i, dir] : starts) {
+        int x = i % width;
+        int y = i / width;
+        int line = isHorizontal(dir) ? y : x;
+        first[dir][line] = std::min(first[dir][line], progress(x, y, dir));
+    }
+
+    for (int d = 0; d < 4; d++) {
+        Direction dir = static_cast<Direction>(d);
+        for (int line = 0; line < static_cast<int>(first[d].size()); line++) {
+            if (first[d][line] == INT_MAX) continue;
+
+            Lane lane;
+            lane.dir = dir;
+            lane.line = line;
+            lane.offset = first[d][line];
+            lane.clearDistance = isHorizontal(dir) ? width : height;
+            lane.length = lane.clearDistance - lane.offset;
+            lane.cell.resize(lane.length);
+            lane.flags.assign(lane.length, 0);
+            lane.occupant.assign(lane.length, -1);
+
+            for (int p = 0; p < lane.length; p++) {
+                int along = lane.offset + p;
+                int x, y;
+                switch (dir) {
+                    case Direction::RIGHT: x = along;             y = line; break;
+                    case Direction::LEFT:  x = width - 1 - along; y = line; break;
+                    case Direction::DOWN:  x = line; y = along;              break;
+                    case Direction::UP:    x = line; y = height - 1 - along; break;
+                }
+                lane.cell[p] = y * width + x;
+                if (cells[lane.cell[p]].hasTrafficLight())
+                    lane.flags[p] |= Lane::STOP_LINE;
+                if (cells[lane.cell[p]].hasTurn())
+                    lane.flags[p] |= Lane::TURN;
+            }
+
+            laneByLine[d][line] = static_cast<int>(lanes.size());
+            lanes.push_back(std::move(lane));
+        }
+    }
+
+    // Crossings and turn links need all lanes in place
+    for (int l = 0; l < static_cast<int>(lanes.size()); l++) {
+        Lane& lane = lanes[l];
+        for (int p = 0; p < lane.length; p++) {
+            int x = lane.cell[p] % width;
+            int y = lane.cell[p] / width;
+
+            for (int d = 0; d < 4; d++) {
+                if (d != lane.dir && locate(x, y, static_cast<Direction>(d)).valid())
+                    lane.flags[p] |= Lane::SHARED;
+            }
+
+            if (lane.flags[p] & Lane::TURN) {
+                Direction turnDir = cells[lane.cell[p]].getTurnDirection();
+                if (turnDir != lane.dir)
+                    lane.links.push_back({p, locate(x, y, turnDir)});
+            }
+        }
+
+        // Distances to the next turn block, filled from the lane end backwards
+        lane.nextTurn.assign(lane.length, Lane::NONE);
+        auto further = [](int dist) { return dist == Lane::NONE ? Lane::NONE : dist + 1; };
+        for (int p = lane.length - 2; p >= 0; p--)
+            lane.nextTurn[p] = (lane.flags[p + 1] & Lane::TURN) ? 1 : further(lane.nextTurn[p + 1]);
+
+        size_t words = (lane.length + 63) / 64;
+        lane.occupiedBits.assign(words, 0);
+        lane.redBits.assign(words, 0);
+    }
+}
+
+LanePos LaneGraph::locate(int x, int y, Direction dir) const {
+    if (x < 0 || x >= width || y < 0 || y >= height)
+        return {};
+
+    int lane = laneByLine[dir][isHorizontal(dir) ? y : x];
+    if (lane < 0)
+        return {};
+
+    int pos = progress(x, y, dir) - lanes[lane].offset;
+    if (pos < 0)
+        return {};
+    return {lane, pos};
+}
+
+const LaneLink* LaneGraph::findLink(int lane, int pos) const {
+    for (const LaneLink& link : lanes[lane].links) {
+        if (link.pos == pos)
+            return &link;
+    }
+    return nullptr;
+}
+
+void LaneGraph::setOccupant(LanePos at, int slot) {
+    Lane& lane = lanes[at.lane];
+    lane.place(at.pos, slot);
+    if (!(lane.flags[at.pos] & Lane::SHARED))
+        return;
+
+    int x = lane.cell[at.pos] % width;
+    int y = lane.cell[at.pos] / width;
+    for (int d = 0; d < 4; d++) {
+        if (d == lane.dir) continue;
+        LanePos alias = locate(x, y, static_cast<Direction>(d));
+        if (alias.valid())
+            lanes[alias.lane].place(alias.pos, slot);
+    }
+}
+
+void LaneGraph::setRed(int cell, bool red) {
+    int x = cell % width;
+    int y = cell / width;
+    for (int d = 0; d < 4; d++) {
+        LanePos at = locate(x, y, static_cast<Direction>(d));
+        if (at.valid())
+            lanes[at.lane].setRed(at.pos, red);
+    }
+}
+
+int LaneGraph::occupantAt(int x, int y) const {
+    // Every lane through a cell holds the same occupant, the first one is enough
+    for (int d = 0; d < 4; d++) {
+        LanePos at = locate(x, y, static_cast<Direction>(d));
+        if (at.valid())
+            return getOccupant(at);
+    }
+    return -1;
+}
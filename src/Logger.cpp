@@ -3,6 +3,8 @@
  * @authors Michal Repcik (xrepcim00)
  */
 #include "Logger.hpp"
+#include "BinaryIO.hpp"
+#include "ColumnWriter.hpp"
 #include <fstream>
 #include <iostream>
 #include <filesystem>
@@ -11,10 +13,140 @@
 #include <algorithm>
 
 void Logger::logTimestep(const TimestepMetrics& metrics) {
+    lastTimestep = metrics;
+    loggedSteps++;
+    if (metrics.step % sampling.stride == 0)
+        recordTimestep(metrics);
+}
+
+void Logger::recordTimestep(const TimestepMetrics& metrics) {
+    accumulate(stepTotals, metrics, 1);
+    int queue = maxQueueOf(metrics);
+    maxQueue = std::max(maxQueue, queue);
+    if (timestepStream)
+        writeTimestepRow(*timestepStream, metrics);
+    if (!keepTimesteps)
+        return;
+
     timestepData.push_back(metrics);
+    if (metrics.step < warmupSteps) {
+        accumulate(warmupStepTotals, metrics, 1);
+        warmupIndex++;
+    }
+    while (!queuePeaks.empty() && maxQueueOf(timestepData[queuePeaks.back()]) <= queue)
+        queuePeaks.pop_back();
+    queuePeaks.push_back(timestepData.size() - 1);
+}
+
+void Logger::accumulate(StepTotals& totals, const TimestepMetrics& metrics, int sign) {
+    totals.steps += sign;
+    totals.velocity += sign * metrics.avgVelocity;
+    totals.stopped += sign * metrics.carsAtZeroVelocity;
+    totals.carsInSystem += sign * metrics.totalCarsInSystem;
+}
+
+void Logger::accumulate(SpawnCohort& totals, const SpawnCohort& cohort, int sign) {
+    totals.exited += sign * cohort.exited;
+    totals.timeInSystem += sign * cohort.timeInSystem;
+    totals.stopped += sign * cohort.stopped;
+}
+
+int Logger::maxQueueOf(const TimestepMetrics& metrics) {
+    return std::max({metrics.maxQueueNorth, metrics.maxQueueSouth, metrics.maxQueueEast, metrics.maxQueueWest});
 }
 
-void Logger::logVehicleSpawn(int vehicleId, int step, Direction spawnDir, bool willTurn) {
+void Logger::setWarmup(int steps) {
+    // Move the boundaries of the warm-up totals, only the steps in between are visited
+    int previous = warmupSteps;
+    warmupSteps = steps;
+    while (warmupIndex < timestepData.size() && timestepData[warmupIndex].step < warmupSteps)
+        accumulate(warmupStepTotals, timestepData[warmupIndex++], 1);
+    while (warmupIndex > 0 && timestepData[warmupIndex - 1].step >= warmupSteps)
+        accumulate(warmupStepTotals, timestepData[--warmupIndex], -1);
+
+    int limit = static_cast<int>(cohorts.size());
+    for (int spawn = previous; spawn < std::min(warmupSteps, limit); spawn++) {
+        accumulate(warmupExitedTotals, cohorts[spawn], 1);
+        sketchCohort(spawn, -1);
+    }
+    for (int spawn = warmupSteps; spawn < std::min(previous, limit); spawn++) {
+        accumulate(warmupExitedTotals, cohorts[spawn], -1);
+        sketchCohort(spawn, 1);
+    }
+}
+
+void Logger::sketchCohort(int spawn, int sign) {
+    for (const ExitDelay& vehicle : cohortDelays[spawn]) {
+        if (sign > 0) {
+            sketches.timeInSystem.add(vehicle.timeInSystem);
+            sketches.waitingTime.add(vehicle.waitingTime);
+            sketches.approachWaiting[vehicle.dir].add(vehicle.waitingTime);
+        } else {
+            sketches.timeInSystem.remove(vehicle.timeInSystem);
+            sketches.waitingTime.remove(vehicle.waitingTime);
+            sketches.approachWaiting[vehicle.dir].remove(vehicle.waitingTime);
+        }
+    }
+}
+
+void Logger::rebuildTotals() {
+    stepTotals = StepTotals{};
+    warmupStepTotals = StepTotals{};
+    warmupIndex = 0;
+    exitedTotals = SpawnCohort{};
+    warmupExitedTotals = SpawnCohort{};
+    sketches = DelaySketches{};
+    queuePeaks.clear();
+    maxQueue = 0;
+
+    // Replaying the recorded steps builds the step totals, the warm-up part and the queue peaks
+    std::vector<TimestepMetrics> recorded = std::move(timestepData);
+    timestepData.clear();
+    for (const TimestepMetrics& metrics : recorded)
+        recordTimestep(metrics);
+    for (int spawn = 0; spawn < static_cast<int>(cohorts.size()); spawn++) {
+        accumulate(exitedTotals, cohorts[spawn], 1);
+        if (spawn < warmupSteps)
+            accumulate(warmupExitedTotals, cohorts[spawn], 1);
+        else
+            sketchCohort(spawn, 1);
+    }
+}
+
+void Logger::setSampling(const LogSampling& s) {
+    sampling = s;
+    sampling.stride = std::max(sampling.stride, 1);
+    buildSpatialMask();
+}
+
+bool Logger::isSampled(int vehicleId) const {
+    if (sampling.vehicleRate >= 1.0)
+        return true;
+
+    // SplitMix64 finalizer, consecutive IDs give independent uniform hashes
+    uint64_t h = static_cast<uint64_t>(vehicleId) + 0x9E3779B97F4A7C15ULL;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+    return static_cast<double>(h >> 11) * (1.0 / 9007199254740992.0) < sampling.vehicleRate;
+}
+
+void Logger::buildSpatialMask() {
+    spatialMask.clear();
+    if (sampling.regions.empty() || spatialWidth == 0)
+        return;
+
+    int height = static_cast<int>(spatialData.size()) / spatialWidth;
+    spatialMask.assign(spatialData.size(), 0);
+    for (const SpatialRegion& region : sampling.regions) {
+        for (int y = std::max(region.y0, 0); y <= std::min(region.y1, height - 1); y++) {
+            for (int x = std::max(region.x0, 0); x <= std::min(region.x1, spatialWidth - 1); x++)
+                spatialMask[static_cast<size_t>(y) * spatialWidth + x] = 1;
+        }
+    }
+}
+
+void Logger::logVehicleSpawn(int slot, int vehicleId, int step, Direction spawnDir, bool willTurn) {
     VehicleTrajectory traj;
     traj.vehicleId = vehicleId;
     traj.spawnStep = step;
@@ -26,52 +158,95 @@ void Logger::logVehicleSpawn(int vehicleId, int step, Direction spawnDir, bool w
     traj.spawnDirection = spawnDir;
     traj.didTurn = willTurn;
     traj.maxVelocity = 0;
-    
-    vehicleData[vehicleId] = traj;
-}
 
-void Logger::logVehicleExit(int vehicleId, int step) {
-    if (vehicleData.find(vehicleId) != vehicleData.end()) {
-        vehicleData[vehicleId].exitStep = step;
-        vehicleData[vehicleId].totalSteps = step - vehicleData[vehicleId].spawnStep;
+    // Slots of vehicles that were never spawned (initial cars) stay untracked
+    if (slot >= static_cast<int>(vehicleData.size())) {
+        VehicleTrajectory untracked{};
+        untracked.vehicleId = UNTRACKED;
+        vehicleData.resize(slot + 1, untracked);
+    }
+
+    // Vehicles outside the sample keep only their approach, so they still count in the direction totals
+    if (!isSampled(vehicleId)) {
+        traj.vehicleId = UNSAMPLED;
+        vehicleData[slot] = traj;
+        return;
     }
+    vehicleData[slot] = traj;
+    if (paths)
+        paths->start(slot, vehicleId, step);
 }
 
-void Logger::logVehicleState(int vehicleId, int step, int x, int y, int velocity) {
-    if (vehicleData.find(vehicleId) == vehicleData.end()) {
+void Logger::logVehicleExit(int slot, int step) {
+    if (slot >= static_cast<int>(vehicleData.size()) || vehicleData[slot].vehicleId == UNTRACKED)
+        return;
+    vehicleData[slot].exitStep = step;
+    vehicleData[slot].totalSteps = step - vehicleData[slot].spawnStep;
+    finishVehicle(slot);
+}
+
+void Logger::logVehicleLost(int slot, int step) {
+    if (slot >= static_cast<int>(vehicleData.size()) || vehicleData[slot].vehicleId == UNTRACKED)
+        return;
+    vehicleData[slot].totalSteps = step - vehicleData[slot].spawnStep;
+    finishVehicle(slot);
+}
+
+void Logger::finishVehicle(int slot) {
+    VehicleTrajectory& traj = vehicleData[slot];
+    VehicleTotals& totals = finishedTotals[traj.spawnDirection];
+    totals.vehicles++;
+    if (traj.exitStep > 0)
+        totals.exited++;
+    if (traj.vehicleId == UNSAMPLED) {
+        traj.vehicleId = UNTRACKED;
         return;
     }
-    
-    VehicleTrajectory& traj = vehicleData[vehicleId];
-    
-    // Update statistics
-    if (velocity == 0) {
-        traj.stepsAtZeroVelocity++;
+
+    if (traj.exitStep > 0) {
+        totals.sampledExited++;
+        totals.velocitySum += traj.avgVelocity;
+        totals.stoppedSum += traj.stepsAtZeroVelocity;
+
+        if (traj.spawnStep >= static_cast<int>(cohorts.size())) {
+            cohorts.resize(traj.spawnStep + 1);
+            cohortDelays.resize(traj.spawnStep + 1);
+        }
+        SpawnCohort vehicle{1, traj.totalSteps, traj.stepsAtZeroVelocity};
+        accumulate(cohorts[traj.spawnStep], vehicle, 1);
+        accumulate(exitedTotals, vehicle, 1);
+        cohortDelays[traj.spawnStep].push_back({traj.totalSteps, traj.stepsAtZeroVelocity, traj.spawnDirection});
+        if (traj.spawnStep < warmupSteps) {
+            accumulate(warmupExitedTotals, vehicle, 1);
+        } else {
+            sketches.timeInSystem.add(traj.totalSteps);
+            sketches.waitingTime.add(traj.stepsAtZeroVelocity);
+            sketches.approachWaiting[traj.spawnDirection].add(traj.stepsAtZeroVelocity);
+        }
     }
-    
-    traj.totalDistance += velocity;
-    traj.maxVelocity = std::max(traj.maxVelocity, velocity);
-    
-    // Update average velocity (incremental)
-    int currentSteps = step - traj.spawnStep + 1;
-    traj.avgVelocity = ((traj.avgVelocity * (currentSteps - 1)) + velocity) / currentSteps;
+
+    if (trajectoryStream)
+        writeTrajectoryRow(*trajectoryStream, traj);
+    if (paths)
+        paths->finish(slot, traj.exitStep > 0 ? PathEnd::EXITED : PathEnd::LOST);
+    if (keepVehicleRecords)
+        finishedVehicles.push_back(traj);
+    traj.vehicleId = UNTRACKED;
 }
 
-void Logger::logSpatialData(int x, int y, int velocity) {
-    auto key = std::make_pair(x, y);
-    
-    if (spatialData.find(key) == spatialData.end()) {
-        SpatialData data;
-        data.x = x;
-        data.y = y;
-        data.totalVelocity = 0;
-        data.observations = 0;
-        data.avgVelocity = 0.0;
-        spatialData[key] = data;
+VehicleTotals Logger::getVehicleTotals(Direction dir) const {
+    VehicleTotals totals = finishedTotals[dir];
+    for (const VehicleTrajectory& traj : vehicleData) {
+        if (traj.vehicleId != UNTRACKED && traj.spawnDirection == dir)
+            totals.vehicles++;
     }
-    
-    spatialData[key].totalVelocity += velocity;
-    spatialData[key].observations++;
+    return totals;
+}
+
+void Logger::setSpatialSize(int width, int height) {
+    spatialWidth = width;
+    spatialData.assign(static_cast<size_t>(width) * height, SpatialData{});
+    buildSpatialMask();
 }
 
 void Logger::logDirectionMetrics(const DirectionMetrics& metrics) {
@@ -79,88 +254,155 @@ void Logger::logDirectionMetrics(const DirectionMetrics& metrics) {
 }
 
 void Logger::finalizeData() {
-    // Compute final averages for spatial data
-    for (auto& [key, data] : spatialData) {
-        if (data.observations > 0) {
-            data.avgVelocity = static_cast<double>(data.totalVelocity) / data.observations;
-        }
-    }
-    
     // Finalize vehicle trajectories
-    for (auto& [id, traj] : vehicleData) {
-        if (traj.exitStep == -1 && !timestepData.empty()) {
-            traj.totalSteps = timestepData.back().step - traj.spawnStep;
-        }
+    if (loggedSteps == 0)
+        return;
+    for (VehicleTrajectory& traj : vehicleData) {
+        if (traj.vehicleId >= 0)
+            traj.totalSteps = lastTimestep.step - traj.spawnStep;
     }
 }
 
+void Logger::writeTimestepHeader(CsvWriter& out) {
+    out.raw("step,totalCars,carsEntered,carsExited,avgVelocity,"
+            "avgVelNorth,avgVelSouth,avgVelEast,avgVelWest,"
+            "stoppedCars,maxQueueN,maxQueueS,maxQueueE,maxQueueW,"
+            "carsAtRedLight,avgTimeInSystem,avgWaitTime\n");
+}
+
+void Logger::writeTimestepRow(CsvWriter& out, const TimestepMetrics& metrics) {
+    out.field(metrics.step)
+       .field(metrics.totalCarsInSystem)
+       .field(metrics.carsEntered)
+       .field(metrics.carsExited)
+       .field(metrics.avgVelocity)
+       .field(metrics.avgVelocityNorth)
+       .field(metrics.avgVelocitySouth)
+       .field(metrics.avgVelocityEast)
+       .field(metrics.avgVelocityWest)
+       .field(metrics.carsAtZeroVelocity)
+       .field(metrics.maxQueueNorth)
+       .field(metrics.maxQueueSouth)
+       .field(metrics.maxQueueEast)
+       .field(metrics.maxQueueWest)
+       .field(metrics.carsWaitingAtRedLight)
+       .field(metrics.avgTimeInSystem)
+       .field(metrics.avgWaitingTime)
+       .endRow();
+}
+
+void Logger::writeTrajectoryHeader(CsvWriter& out) {
+    out.raw("vehicleId,spawnStep,exitStep,totalSteps,stepsAtZero,"
+            "totalDistance,avgVelocity,spawnDirection,didTurn,maxVelocity\n");
+}
+
+void Logger::writeTrajectoryRow(CsvWriter& out, const VehicleTrajectory& traj) const {
+    out.field(traj.vehicleId)
+       .field(traj.spawnStep)
+       .field(traj.exitStep)
+       .field(traj.totalSteps)
+       .field(traj.stepsAtZeroVelocity)
+       .field(traj.totalDistance)
+       .field(traj.avgVelocity)
+       .field(directionToString(traj.spawnDirection))
+       .field(traj.didTurn ? 1 : 0)
+       .field(traj.maxVelocity)
+       .endRow();
+}
+
 void Logger::exportTimestepMetrics(const std::string& filename) const {
-    std::ofstream file(filename);
-    if (!file) {
+    CsvWriter file;
+    if (!file.open(filename)) {
         std::cerr << "Error: Cannot open file " << filename << std::endl;
         return;
     }
     
-    // Header
-    file << "step,totalCars,carsEntered,carsExited,avgVelocity,"
-         << "avgVelNorth,avgVelSouth,avgVelEast,avgVelWest,"
-         << "stoppedCars,maxQueueN,maxQueueS,maxQueueE,maxQueueW,"
-         << "carsAtRedLight,avgTimeInSystem,avgWaitTime\n";
-    
-    // Data
-    for (const auto& metrics : timestepData) {
-        file << metrics.step << ","
-             << metrics.totalCarsInSystem << ","
-             << metrics.carsEntered << ","
-             << metrics.carsExited << ","
-             << std::fixed << std::setprecision(4) << metrics.avgVelocity << ","
-             << metrics.avgVelocityNorth << ","
-             << metrics.avgVelocitySouth << ","
-             << metrics.avgVelocityEast << ","
-             << metrics.avgVelocityWest << ","
-             << metrics.carsAtZeroVelocity << ","
-             << metrics.maxQueueNorth << ","
-             << metrics.maxQueueSouth << ","
-             << metrics.maxQueueEast << ","
-             << metrics.maxQueueWest << ","
-             << metrics.carsWaitingAtRedLight << ","
-             << metrics.avgTimeInSystem << ","
-             << metrics.avgWaitingTime << "\n";
-    }
+    writeTimestepHeader(file);
+    for (const auto& metrics : timestepData)
+        writeTimestepRow(file, metrics);
     
     file.close();
     std::cout << "Exported timestep metrics to: " << filename << std::endl;
 }
 
 void Logger::exportVehicleTrajectories(const std::string& filename) const {
-    std::ofstream file(filename);
-    if (!file) {
+    CsvWriter file;
+    if (!file.open(filename)) {
         std::cerr << "Error: Cannot open file " << filename << std::endl;
         return;
     }
     
-    // Header
-    file << "vehicleId,spawnStep,exitStep,totalSteps,stepsAtZero,"
-         << "totalDistance,avgVelocity,spawnDirection,didTurn,maxVelocity\n";
-    
-    // Data
-    for (const auto& [id, traj] : vehicleData) {
-        file << traj.vehicleId << ","
-             << traj.spawnStep << ","
-             << traj.exitStep << ","
-             << traj.totalSteps << ","
-             << traj.stepsAtZeroVelocity << ","
-             << traj.totalDistance << ","
-             << std::fixed << std::setprecision(4) << traj.avgVelocity << ","
-             << directionToString(traj.spawnDirection) << ","
-             << (traj.didTurn ? 1 : 0) << ","
-             << traj.maxVelocity << "\n";
+    // Vehicles that left the grid in order of leaving, then the ones still on it
+    writeTrajectoryHeader(file);
+    for (const VehicleTrajectory& traj : finishedVehicles)
+        writeTrajectoryRow(file, traj);
+    for (const VehicleTrajectory& traj : vehicleData) {
+        if (traj.vehicleId >= 0)
+            writeTrajectoryRow(file, traj);
     }
     
     file.close();
     std::cout << "Exported vehicle trajectories to: " << filename << std::endl;
 }
 
+void Logger::exportTimestepColumns(const std::string& filename) const {
+    const std::vector<TimestepMetrics>& t = timestepData;
+    ColumnWriter file(t.size());
+    file.add<int32_t>("step", [&](size_t i) { return t[i].step; });
+    file.add<int32_t>("totalCars", [&](size_t i) { return t[i].totalCarsInSystem; });
+    file.add<int32_t>("carsEntered", [&](size_t i) { return t[i].carsEntered; });
+    file.add<int32_t>("carsExited", [&](size_t i) { return t[i].carsExited; });
+    file.add<double>("avgVelocity", [&](size_t i) { return t[i].avgVelocity; });
+    file.add<double>("avgVelNorth", [&](size_t i) { return t[i].avgVelocityNorth; });
+    file.add<double>("avgVelSouth", [&](size_t i) { return t[i].avgVelocitySouth; });
+    file.add<double>("avgVelEast", [&](size_t i) { return t[i].avgVelocityEast; });
+    file.add<double>("avgVelWest", [&](size_t i) { return t[i].avgVelocityWest; });
+    file.add<int32_t>("stoppedCars", [&](size_t i) { return t[i].carsAtZeroVelocity; });
+    file.add<int32_t>("maxQueueN", [&](size_t i) { return t[i].maxQueueNorth; });
+    file.add<int32_t>("maxQueueS", [&](size_t i) { return t[i].maxQueueSouth; });
+    file.add<int32_t>("maxQueueE", [&](size_t i) { return t[i].maxQueueEast; });
+    file.add<int32_t>("maxQueueW", [&](size_t i) { return t[i].maxQueueWest; });
+    file.add<int32_t>("carsAtRedLight", [&](size_t i) { return t[i].carsWaitingAtRedLight; });
+    file.add<double>("avgTimeInSystem", [&](size_t i) { return t[i].avgTimeInSystem; });
+    file.add<double>("avgWaitTime", [&](size_t i) { return t[i].avgWaitingTime; });
+
+    if (!file.write(filename)) {
+        std::cerr << "Error: Cannot open file " << filename << std::endl;
+        return;
+    }
+    std::cout << "Exported timestep metrics to: " << filename << std::endl;
+}
+
+void Logger::exportTrajectoryColumns(const std::string& filename) const {
+    // Same row order as the CSV: vehicles that left the grid, then the ones still on it
+    std::vector<const VehicleTrajectory*> rows;
+    rows.reserve(finishedVehicles.size() + vehicleData.size());
+    for (const VehicleTrajectory& traj : finishedVehicles)
+        rows.push_back(&traj);
+    for (const VehicleTrajectory& traj : vehicleData) {
+        if (traj.vehicleId >= 0)
+            rows.push_back(&traj);
+    }
+
+    ColumnWriter file(rows.size());
+    file.add<int32_t>("vehicleId", [&](size_t i) { return rows[i]->vehicleId; });
+    file.add<int32_t>("spawnStep", [&](size_t i) { return rows[i]->spawnStep; });
+    file.add<int32_t>("exitStep", [&](size_t i) { return rows[i]->exitStep; });
+    file.add<int32_t>("totalSteps", [&](size_t i) { return rows[i]->totalSteps; });
+    file.add<int32_t>("stepsAtZero", [&](size_t i) { return rows[i]->stepsAtZeroVelocity; });
+    file.add<int32_t>("totalDistance", [&](size_t i) { return rows[i]->totalDistance; });
+    file.add<double>("avgVelocity", [&](size_t i) { return rows[i]->avgVelocity; });
+    file.addText("spawnDirection", 5, [&](size_t i) { return directionToString(rows[i]->spawnDirection); });
+    file.add<uint8_t>("didTurn", [&](size_t i) { return rows[i]->didTurn; });
+    file.add<int32_t>("maxVelocity", [&](size_t i) { return rows[i]->maxVelocity; });
+
+    if (!file.write(filename)) {
+        std::cerr << "Error: Cannot open file " << filename << std::endl;
+        return;
+    }
+    std::cout << "Exported vehicle trajectories to: " << filename << std::endl;
+}
+
 void Logger::exportSpatialHeatmap(const std::string& filename) const {
     std::ofstream file(filename);
     if (!file) {
@@ -171,13 +413,17 @@ void Logger::exportSpatialHeatmap(const std::string& filename) const {
     // Header
     file << "x,y,totalVelocity,observations,avgVelocity\n";
     
-    // Data
-    for (const auto& [key, data] : spatialData) {
-        file << data.x << ","
-             << data.y << ","
+    // Data (one linear pass, cells no car visited are left out)
+    for (size_t i = 0; i < spatialData.size(); i++) {
+        const SpatialData& data = spatialData[i];
+        if (data.observations == 0)
+            continue;
+        file << i % spatialWidth << ","
+             << i / spatialWidth << ","
              << data.totalVelocity << ","
              << data.observations << ","
-             << std::fixed << std::setprecision(4) << data.avgVelocity << "\n";
+             << std::fixed << std::setprecision(4)
+             << static_cast<double>(data.totalVelocity) / data.observations << "\n";
     }
     
     file.close();
@@ -217,88 +463,238 @@ void Logger::exportSummaryStatistics(const std::string& filename) const {
         return;
     }
     
-    if (timestepData.empty()) {
+    if (loggedSteps == 0) {
         std::cerr << "Warning: No data to export" << std::endl;
         return;
     }
     
-    // Compute summary statistics
-    int totalSteps = timestepData.size();
-    int totalCarsSpawned = timestepData.back().carsEntered;
-    int totalCarsExited = timestepData.back().carsExited;
-    
-    // Average metrics over all timesteps
-    double avgVelocityOverall = 0.0;
-    double avgStoppedCars = 0.0;
-    int maxQueueOverall = 0;
-    
-    for (const auto& m : timestepData) {
-        avgVelocityOverall += m.avgVelocity;
-        avgStoppedCars += m.carsAtZeroVelocity;
-        maxQueueOverall = std::max({maxQueueOverall, m.maxQueueNorth, 
-                                    m.maxQueueSouth, m.maxQueueEast, m.maxQueueWest});
-    }
-    avgVelocityOverall /= totalSteps;
-    avgStoppedCars /= totalSteps;
-    
-    // Vehicle-based statistics
-    double avgTimeInSystem = 0.0;
-    double avgWaitingTime = 0.0;
-    int completedVehicles = 0;
-    
-    for (const auto& [id, traj] : vehicleData) {
-        if (traj.exitStep > 0) {
-            avgTimeInSystem += traj.totalSteps;
-            avgWaitingTime += traj.stepsAtZeroVelocity;
-            completedVehicles++;
-        }
-    }
-    
-    if (completedVehicles > 0) {
-        avgTimeInSystem /= completedVehicles;
-        avgWaitingTime /= completedVehicles;
-    }
-    
-    // Throughput (vehicles per minute)
-    double throughput = (totalCarsExited * 60.0) / totalSteps;
+    SummaryStatistics summary = computeSummary();
     
     // Header
     file << "metric,value\n";
     
     // Export
-    file << "totalSteps," << totalSteps << "\n"
-         << "totalCarsSpawned," << totalCarsSpawned << "\n"
-         << "totalCarsExited," << totalCarsExited << "\n"
+    if (summary.warmupSteps > 0)
+        file << "warmupSteps," << summary.warmupSteps << "\n";
+    file << "totalSteps," << summary.totalSteps << "\n"
+         << "totalCarsSpawned," << summary.totalCarsSpawned << "\n"
+         << "totalCarsExited," << summary.totalCarsExited << "\n"
          << "completionRate," << std::fixed << std::setprecision(4) 
-         << (totalCarsSpawned > 0 ? (double)totalCarsExited/totalCarsSpawned : 0.0) << "\n"
-         << "avgVelocity," << avgVelocityOverall << "\n"
-         << "avgStoppedCars," << avgStoppedCars << "\n"
-         << "maxQueueLength," << maxQueueOverall << "\n"
-         << "avgTimeInSystem," << avgTimeInSystem << "\n"
-         << "avgWaitingTime," << avgWaitingTime << "\n"
-         << "throughputPerMinute," << throughput << "\n";
+         << summary.completionRate << "\n"
+         << "avgVelocity," << summary.avgVelocity << "\n"
+         << "avgStoppedCars," << summary.avgStoppedCars << "\n"
+         << "maxQueueLength," << summary.maxQueueLength << "\n"
+         << "avgTimeInSystem," << summary.avgTimeInSystem << "\n"
+         << "avgWaitingTime," << summary.avgWaitingTime << "\n"
+         << "timeInSystemP50," << summary.timeInSystemP50 << "\n"
+         << "timeInSystemP95," << summary.timeInSystemP95 << "\n"
+         << "timeInSystemP99," << summary.timeInSystemP99 << "\n"
+         << "waitingTimeP50," << summary.waitingTimeP50 << "\n"
+         << "waitingTimeP95," << summary.waitingTimeP95 << "\n"
+         << "waitingTimeP99," << summary.waitingTimeP99 << "\n"
+         << "throughputPerMinute," << summary.throughputPerMinute << "\n";
     
     file.close();
     std::cout << "Exported summary statistics to: " << filename << std::endl;
 }
 
+void DelaySketches::merge(const DelaySketches& other) {
+    timeInSystem.merge(other.timeInSystem);
+    waitingTime.merge(other.waitingTime);
+    for (size_t dir = 0; dir < approachWaiting.size(); dir++)
+        approachWaiting[dir].merge(other.approachWaiting[dir]);
+}
+
+void Logger::exportDelayQuantiles(const DelaySketches& sketches, const std::string& filename) {
+    std::ofstream file(filename);
+    if (!file) {
+        std::cerr << "Error: Cannot open file " << filename << std::endl;
+        return;
+    }
+
+    file << "metric,approach,vehicles,mean,p50,p90,p95,p99,max\n" << std::fixed << std::setprecision(4);
+    auto row = [&](const char* metric, const std::string& approach, const QuantileSketch& sketch) {
+        file << metric << "," << approach << "," << sketch.count() << "," << sketch.mean() << ","
+             << sketch.quantile(0.5) << "," << sketch.quantile(0.9) << "," << sketch.quantile(0.95) << ","
+             << sketch.quantile(0.99) << "," << sketch.max() << "\n";
+    };
+    row("timeInSystem", "ALL", sketches.timeInSystem);
+    row("waitingTime", "ALL", sketches.waitingTime);
+    for (Direction dir : {LEFT, RIGHT, UP, DOWN}) {
+        if (sketches.approachWaiting[dir].count() > 0)
+            row("waitingTime", directionToString(dir), sketches.approachWaiting[dir]);
+    }
+
+    file.close();
+    std::cout << "Exported delay quantiles to: " << filename << std::endl;
+}
+
 void Logger::exportAll(const std::string& directory) const {
     std::filesystem::create_directories(directory);
-    exportTimestepMetrics(directory + "/timestep_metrics.csv");
-    exportVehicleTrajectories(directory + "/vehicle_trajectories.csv");
+    if (streamed) {
+        // Written while the simulation ran
+    } else if (columnarExport) {
+        exportTimestepColumns(directory + "/timestep_metrics.col");
+        exportTrajectoryColumns(directory + "/vehicle_trajectories.col");
+    } else {
+        exportTimestepMetrics(directory + "/timestep_metrics.csv");
+        exportVehicleTrajectories(directory + "/vehicle_trajectories.csv");
+    }
     exportSpatialHeatmap(directory + "/spatial_heatmap.csv");
     exportDirectionMetrics(directory + "/direction_metrics.csv");
     exportSummaryStatistics(directory + "/summary_statistics.csv");
+    exportDelayQuantiles(sketches, directory + "/delay_quantiles.csv");
+}
+
+bool Logger::startStreaming(const std::string& directory) {
+    std::filesystem::create_directories(directory);
+    timestepStream = std::make_unique<CsvWriter>();
+    trajectoryStream = std::make_unique<CsvWriter>();
+    for (auto [stream, name] : {std::pair{timestepStream.get(), "/timestep_metrics.csv"},
+                                std::pair{trajectoryStream.get(), "/vehicle_trajectories.csv"}}) {
+        if (!stream->open(directory + name)) {
+            std::cerr << "Error: Cannot open file " << directory + name << std::endl;
+            timestepStream.reset();
+            trajectoryStream.reset();
+            return false;
+        }
+    }
+    writeTimestepHeader(*timestepStream);
+    writeTrajectoryHeader(*trajectoryStream);
+    streamDirectory = directory;
+    streamed = true;
+    return true;
+}
+
+bool Logger::stopStreaming() {
+    if (!trajectoryStream)
+        return true;
+    finalizeData();
+    for (const VehicleTrajectory& traj : vehicleData) {
+        if (traj.vehicleId >= 0)
+            writeTrajectoryRow(*trajectoryStream, traj);
+    }
+
+    bool ok = true;
+    for (auto [stream, name] : {std::pair{timestepStream.get(), "/timestep_metrics.csv"},
+                                std::pair{trajectoryStream.get(), "/vehicle_trajectories.csv"}}) {
+        if (!stream->close()) {
+            std::cerr << "Error: Cannot write file " << streamDirectory + name << std::endl;
+            ok = false;
+        }
+    }
+    timestepStream.reset();
+    trajectoryStream.reset();
+    if (ok)
+        std::cout << "Streamed timestep metrics and vehicle trajectories" << std::endl;
+    return ok;
+}
+
+bool Logger::startPaths(const std::string& filename) {
+    paths = std::make_unique<PathRecorder>();
+    int height = spatialWidth > 0 ? static_cast<int>(spatialData.size()) / spatialWidth : 0;
+    if (!paths->open(filename, spatialWidth, height)) {
+        std::cerr << "Error: Cannot open file " << filename << std::endl;
+        paths.reset();
+        return false;
+    }
+    return true;
+}
+
+uint64_t Logger::stopPaths() {
+    if (!paths)
+        return 0;
+    paths->close();
+    uint64_t bytes = paths->getBytesWritten();
+    paths.reset();
+    return bytes;
 }
 
 void Logger::reset() {
     timestepData.clear();
     vehicleData.clear();
-    spatialData.clear();
+    finishedVehicles.clear();
+    cohorts.clear();
+    cohortDelays.clear();
+    finishedTotals.assign(finishedTotals.size(), VehicleTotals{});
+    sketches = DelaySketches{};
+    stepTotals = StepTotals{};
+    warmupStepTotals = StepTotals{};
+    warmupIndex = 0;
+    exitedTotals = SpawnCohort{};
+    warmupExitedTotals = SpawnCohort{};
+    queuePeaks.clear();
+    maxQueue = 0;
+    loggedSteps = 0;
+    lastTimestep = TimestepMetrics{};
+    spatialData.assign(spatialData.size(), SpatialData{});
     directionData.clear();
 }
 
-std::string Logger::directionToString(Direction dir) const {
+void Logger::save(std::ostream& out) const {
+    // Maps are written as their values, every value carries its own key
+    std::vector<DirectionMetrics> directions;
+    for (const auto& [dir, metrics] : directionData)
+        directions.push_back(metrics);
+
+    BinaryIO::write(out, static_cast<uint64_t>(loggedSteps));
+    BinaryIO::write(out, lastTimestep);
+    BinaryIO::writeVector(out, timestepData);
+    BinaryIO::writeVector(out, vehicleData);
+    BinaryIO::writeVector(out, finishedVehicles);
+    BinaryIO::writeVector(out, cohorts);
+    BinaryIO::writeVector(out, finishedTotals);
+    BinaryIO::write(out, spatialWidth);
+    BinaryIO::writeVector(out, spatialData);
+    BinaryIO::writeVector(out, directions);
+    // Delays are written per spawn step, the sketches are rebuilt from them
+    for (const std::vector<ExitDelay>& delays : cohortDelays)
+        BinaryIO::writeVector(out, delays);
+}
+
+bool Logger::load(std::istream& in) {
+    std::vector<TimestepMetrics> timesteps;
+    std::vector<VehicleTrajectory> vehicles, finished;
+    std::vector<SpawnCohort> spawnCohorts;
+    std::vector<VehicleTotals> totals;
+    std::vector<SpatialData> spatial;
+    std::vector<DirectionMetrics> directions;
+    int width = 0;
+    uint64_t steps = 0;
+    TimestepMetrics last{};
+    if (!BinaryIO::read(in, steps) || !BinaryIO::read(in, last) || !BinaryIO::readVector(in, timesteps) || !BinaryIO::readVector(in, vehicles) ||
+        !BinaryIO::readVector(in, finished) || !BinaryIO::readVector(in, spawnCohorts) ||
+        !BinaryIO::readVector(in, totals) || totals.size() != finishedTotals.size() ||
+        !BinaryIO::read(in, width) || !BinaryIO::readVector(in, spatial) || !BinaryIO::readVector(in, directions))
+        return false;
+    std::vector<std::vector<ExitDelay>> delays(spawnCohorts.size());
+    for (std::vector<ExitDelay>& cohort : delays) {
+        if (!BinaryIO::readVector(in, cohort))
+            return false;
+    }
+    // The heatmap has to cover the same grid
+    if (width != spatialWidth || spatial.size() != spatialData.size())
+        return false;
+
+    reset();
+    loggedSteps = steps;
+    lastTimestep = last;
+    timestepData = std::move(timesteps);
+    vehicleData = std::move(vehicles);
+    // Records are only restored if this logger keeps them
+    if (keepVehicleRecords)
+        finishedVehicles = std::move(finished);
+    cohorts = std::move(spawnCohorts);
+    finishedTotals = std::move(totals);
+    spatialData = std::move(spatial);
+    for (const DirectionMetrics& metrics : directions)
+        directionData[metrics.dir] = metrics;
+    cohortDelays = std::move(delays);
+    rebuildTotals();
+    return true;
+}
+
+std::string Logger::directionToString(Direction dir) {
     switch (dir) {
         case Direction::LEFT:  return "WEST";
         case Direction::RIGHT: return "EAST";
@@ -308,49 +704,71 @@ std::string Logger::directionToString(Direction dir) const {
     }
 }
 
-void Logger::printSummaryTable() const {
-    if (timestepData.empty()) {
-        std::cout << "No data to display." << std::endl;
-        return;
+SummaryStatistics Logger::computeSummary() const {
+    SummaryStatistics summary;
+    if (loggedSteps == 0)
+        return summary;
+
+    // Steady-state window starts after the warm-up (whole run if the warm-up covers everything)
+    bool truncated = keepTimesteps && warmupIndex > 0 && warmupIndex < timestepData.size();
+    size_t first = truncated ? warmupIndex : 0;
+    StepTotals steps = stepTotals;
+    SpawnCohort exited = exitedTotals;
+    if (truncated) {
+        steps.steps -= warmupStepTotals.steps;
+        steps.velocity -= warmupStepTotals.velocity;
+        steps.stopped -= warmupStepTotals.stopped;
+        steps.carsInSystem -= warmupStepTotals.carsInSystem;
+        accumulate(exited, warmupExitedTotals, -1);
     }
+    int enteredBefore = first > 0 ? timestepData[first - 1].carsEntered : 0;
+    int exitedBefore = first > 0 ? timestepData[first - 1].carsExited : 0;
 
-    int totalSteps = timestepData.size();
-    int totalCarsSpawned = timestepData.back().carsEntered;
-    int totalCarsExited = timestepData.back().carsExited;
+    // The window starts right after the last recorded warm-up step (recorded steps are stride apart)
+    summary.warmupSteps = first > 0 ? timestepData[first - 1].step + 1 : 0;
+    summary.totalSteps = first > 0 ? lastTimestep.step - timestepData[first - 1].step : loggedSteps;
+    summary.totalCarsSpawned = lastTimestep.carsEntered - enteredBefore;
+    summary.totalCarsExited = lastTimestep.carsExited - exitedBefore;
+    summary.completionRate = summary.totalCarsSpawned > 0
+        ? static_cast<double>(summary.totalCarsExited) / summary.totalCarsSpawned : 0.0;
 
-    double avgVelocityOverall = 0.0;
-    double avgStoppedCars = 0.0;
-    int maxQueueOverall = 0;
+    // Average metrics over the recorded timesteps of the window
+    if (steps.steps > 0) {
+        summary.avgVelocity = steps.velocity / steps.steps;
+        summary.avgStoppedCars = static_cast<double>(steps.stopped) / steps.steps;
+        summary.avgCarsInSystem = static_cast<double>(steps.carsInSystem) / steps.steps;
+    }
+    // Peaks hold the maximum of every suffix, the first one inside the window is the longest queue there
+    if (truncated)
+        summary.maxQueueLength = maxQueueOf(timestepData[*std::lower_bound(queuePeaks.begin(), queuePeaks.end(), first)]);
+    else
+        summary.maxQueueLength = maxQueue;
 
-    for (const auto& m : timestepData) {
-        avgVelocityOverall += m.avgVelocity;
-        avgStoppedCars += m.carsAtZeroVelocity;
-        maxQueueOverall = std::max({maxQueueOverall, m.maxQueueNorth,
-                                    m.maxQueueSouth, m.maxQueueEast, m.maxQueueWest});
+    // Vehicle-based statistics (exited vehicles spawned after the warm-up)
+    if (exited.exited > 0) {
+        summary.avgTimeInSystem = static_cast<double>(exited.timeInSystem) / exited.exited;
+        summary.avgWaitingTime = static_cast<double>(exited.stopped) / exited.exited;
     }
-    avgVelocityOverall /= totalSteps;
-    avgStoppedCars /= totalSteps;
 
-    double avgTimeInSystem = 0.0;
-    double avgWaitingTime = 0.0;
-    int completedVehicles = 0;
+    summary.timeInSystemP50 = sketches.timeInSystem.quantile(0.5);
+    summary.timeInSystemP95 = sketches.timeInSystem.quantile(0.95);
+    summary.timeInSystemP99 = sketches.timeInSystem.quantile(0.99);
+    summary.waitingTimeP50 = sketches.waitingTime.quantile(0.5);
+    summary.waitingTimeP95 = sketches.waitingTime.quantile(0.95);
+    summary.waitingTimeP99 = sketches.waitingTime.quantile(0.99);
 
-    for (const auto& [id, traj] : vehicleData) {
-        if (traj.exitStep > 0) {
-            avgTimeInSystem += traj.totalSteps;
-            avgWaitingTime += traj.stepsAtZeroVelocity;
-            completedVehicles++;
-        }
-    }
+    // Throughput (vehicles per minute)
+    summary.throughputPerMinute = (summary.totalCarsExited * 60.0) / summary.totalSteps;
+    return summary;
+}
 
-    if (completedVehicles > 0) {
-        avgTimeInSystem /= completedVehicles;
-        avgWaitingTime /= completedVehicles;
+void Logger::printSummaryTable() const {
+    if (loggedSteps == 0) {
+        std::cout << "No data to display." << std::endl;
+        return;
     }
 
-    double throughput = (totalCarsExited * 60.0) / totalSteps;
-
-    double completionRate = (totalCarsSpawned > 0) ? static_cast<double>(totalCarsExited) / totalCarsSpawned : 0.0;
+    SummaryStatistics summary = computeSummary();
 
     // Print table
     std::cout << "\nSimulation Summary Statistics:\n";
@@ -358,16 +776,20 @@ void Logger::printSummaryTable() const {
     std::cout << std::left << std::setw(30) << "Metric" << std::setw(20) << "Value" << std::endl;
     std::cout << std::string(50, '-') << std::endl;
 
-    std::cout << std::left << std::setw(30) << "Total Steps (s)" << std::setw(20) << totalSteps << std::endl;
-    std::cout << std::left << std::setw(30) << "Total Cars Spawned" << std::setw(20) << totalCarsSpawned << std::endl;
-    std::cout << std::left << std::setw(30) << "Total Cars Exited" << std::setw(20) << totalCarsExited << std::endl;
-    std::cout << std::left << std::setw(30) << "Average Velocity (cell/s)" << std::fixed << std::setprecision(4) << std::setw(20) << avgVelocityOverall << std::endl;
-    std::cout << std::left << std::setw(30) << "Average Velocity (km/h)" << std::fixed << std::setprecision(4) << std::setw(20) << avgVelocityOverall*18 << std::endl;
-    std::cout << std::left << std::setw(30) << "Average Stopped Cars" << std::fixed << std::setprecision(4) << std::setw(20) << avgStoppedCars << std::endl;
-    std::cout << std::left << std::setw(30) << "Max Queue Length (cells)" << std::setw(20) << maxQueueOverall << std::endl;
-    std::cout << std::left << std::setw(30) << "Max Queue Length (m)" << std::setw(20) << maxQueueOverall*5 << std::endl;
-    std::cout << std::left << std::setw(30) << "Avg Time in System (s)" << std::fixed << std::setprecision(4) << std::setw(20) << avgTimeInSystem << std::endl;
-    std::cout << std::left << std::setw(30) << "Avg Waiting Time (s)" << std::fixed << std::setprecision(4) << std::setw(20) << avgWaitingTime << std::endl;
-    std::cout << std::left << std::setw(30) << "Throughput (veh/min)" << std::fixed << std::setprecision(4) << std::setw(20) << throughput << std::endl;
+    if (summary.warmupSteps > 0)
+        std::cout << std::left << std::setw(30) << "Warm-up Steps (s)" << std::setw(20) << summary.warmupSteps << std::endl;
+    std::cout << std::left << std::setw(30) << "Total Steps (s)" << std::setw(20) << summary.totalSteps << std::endl;
+    std::cout << std::left << std::setw(30) << "Total Cars Spawned" << std::setw(20) << summary.totalCarsSpawned << std::endl;
+    std::cout << std::left << std::setw(30) << "Total Cars Exited" << std::setw(20) << summary.totalCarsExited << std::endl;
+    std::cout << std::left << std::setw(30) << "Average Velocity (cell/s)" << std::fixed << std::setprecision(4) << std::setw(20) << summary.avgVelocity << std::endl;
+    std::cout << std::left << std::setw(30) << "Average Velocity (km/h)" << std::fixed << std::setprecision(4) << std::setw(20) << summary.avgVelocity*18 << std::endl;
+    std::cout << std::left << std::setw(30) << "Average Stopped Cars" << std::fixed << std::setprecision(4) << std::setw(20) << summary.avgStoppedCars << std::endl;
+    std::cout << std::left << std::setw(30) << "Max Queue Length (cells)" << std::setw(20) << summary.maxQueueLength << std::endl;
+    std::cout << std::left << std::setw(30) << "Max Queue Length (m)" << std::setw(20) << summary.maxQueueLength*5 << std::endl;
+    std::cout << std::left << std::setw(30) << "Avg Time in System (s)" << std::fixed << std::setprecision(4) << std::setw(20) << summary.avgTimeInSystem << std::endl;
+    std::cout << std::left << std::setw(30) << "Avg Waiting Time (s)" << std::fixed << std::setprecision(4) << std::setw(20) << summary.avgWaitingTime << std::endl;
+    std::cout << std::left << std::setw(30) << "P95 Time in System (s)" << std::fixed << std::setprecision(4) << std::setw(20) << summary.timeInSystemP95 << std::endl;
+    std::cout << std::left << std::setw(30) << "P95 Waiting Time (s)" << std::fixed << std::setprecision(4) << std::setw(20) << summary.waitingTimeP95 << std::endl;
+    std::cout << std::left << std::setw(30) << "Throughput (veh/min)" << std::fixed << std::setprecision(4) << std::setw(20) << summary.throughputPerMinute << std::endl;
     std::cout << std::string(50, '-') << std::endl << std::endl;
 }
\ No newline at end of file
@@ -0,0 +1,125 @@
+/**
+ * @file NaschKernel.cpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#include "NaschKernel.hpp"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NASCH_X86 1
+#endif
+
+namespace NaschKernel {
+
+static void applyScalar(int16_t* vel, const int16_t* gap, const int16_t* brake, int n, int vmax) {
+    for (int i = 0; i < n; i++) {
+        int v = std::min(vel[i] + 1, vmax);
+        v = std::min(v, gap[i] - 1);
+        vel[i] = static_cast<int16_t>(std::max(v - brake[i], 0));
+    }
+}
+
+#ifdef NASCH_X86
+
+__attribute__((target("sse4.1")))
+static void applySSE41(int16_t* vel, const int16_t* gap, const int16_t* brake, int n, int vmax) {
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i limit = _mm_set1_epi16(static_cast<int16_t>(vmax));
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vel + i));
+        __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(gap + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(brake + i));
+        v = _mm_min_epi16(_mm_add_epi16(v, one), limit);
+        v = _mm_min_epi16(v, _mm_sub_epi16(g, one));
+        v = _mm_max_epi16(_mm_sub_epi16(v, b), zero);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(vel + i), v);
+    }
+    applyScalar(vel + i, gap + i, brake + i, n - i, vmax);
+}
+
+__attribute__((target("avx2")))
+static void applyAVX2(int16_t* vel, const int16_t* gap, const int16_t* brake, int n, int vmax) {
+    const __m256i one = _mm256_set1_epi16(1);
+    const __m256i limit = _mm256_set1_epi16(static_cast<int16_t>(vmax));
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(vel + i));
+        __m256i g = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(gap + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(brake + i));
+        v = _mm256_min_epi16(_mm256_add_epi16(v, one), limit);
+        v = _mm256_min_epi16(v, _mm256_sub_epi16(g, one));
+        v = _mm256_max_epi16(_mm256_sub_epi16(v, b), zero);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(vel + i), v);
+    }
+    applySSE41(vel + i, gap + i, brake + i, n - i, vmax);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static void applyAVX512(int16_t* vel, const int16_t* gap, const int16_t* brake, int n, int vmax) {
+    const __m512i one = _mm512_set1_epi16(1);
+    const __m512i limit = _mm512_set1_epi16(static_cast<int16_t>(vmax));
+    const __m512i zero = _mm512_setzero_si512();
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m512i v = _mm512_loadu_si512(vel + i);
+        __m512i g = _mm512_loadu_si512(gap + i);
+        __m512i b = _mm512_loadu_si512(brake + i);
+        v = _mm512_min_epi16(_mm512_add_epi16(v, one), limit);
+        v = _mm512_min_epi16(v, _mm512_sub_epi16(g, one));
+        v = _mm512_max_epi16(_mm512_sub_epi16(v, b), zero);
+        _mm512_storeu_si512(vel + i, v);
+    }
+    applyAVX2(vel + i, gap + i, brake + i, n - i, vmax);
+}
+
+#endif // NASCH_X86
+
+bool supported(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return true;
+#ifdef NASCH_X86
+        case Isa::SSE41:  return __builtin_cpu_supports("sse4.1");
+        case Isa::AVX2:   return __builtin_cpu_supports("avx2");
+        case Isa::AVX512: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+        default:          return false;
+    }
+}
+
+Isa best() {
+    static const Isa detected = [] {
+        for (Isa isa : {Isa::AVX512, Isa::AVX2, Isa::SSE41}) {
+            if (supported(isa))
+                return isa;
+        }
+        return Isa::Scalar;
+    }();
+    return detected;
+}
+
+const char* name(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::SSE41:  return "SSE4.1";
+        case Isa::AVX2:   return "AVX2";
+        case Isa::AVX512: return "AVX-512BW";
+    }
+    return "unknown";
+}
+
+void apply(int16_t* vel, const int16_t* gap, const int16_t* brake, int n, int vmax, Isa isa) {
+    switch (isa) {
+#ifdef NASCH_X86
+        case Isa::SSE41:  applySSE41(vel, gap, brake, n, vmax); return;
+        case Isa::AVX2:   applyAVX2(vel, gap, brake, n, vmax); return;
+        case Isa::AVX512: applyAVX512(vel, gap, brake, n, vmax); return;
+#endif
+        default:          applyScalar(vel, gap, brake, n, vmax); return;
+    }
+}
+
+} // namespace NaschKernel
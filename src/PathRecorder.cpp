@@ -0,0 +1,76 @@
+/**
+ * @file PathRecorder.cpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#include "PathRecorder.hpp"
+#include "BinaryIO.hpp"
+
+bool PathRecorder::open(const std::string& filename, int width, int height) {
+    file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+    file.write("TRAFPTH1", 8);
+    BinaryIO::write(file, static_cast<uint32_t>(width));
+    BinaryIO::write(file, static_cast<uint32_t>(height));
+    bytesWritten = 16;
+    paths.clear();
+    block.clear();
+    blockRecords = 0;
+    lastSpawn = 0;
+    return static_cast<bool>(file);
+}
+
+void PathRecorder::close() {
+    if (!file.is_open())
+        return;
+    for (int slot = 0; slot < static_cast<int>(paths.size()); slot++) {
+        if (paths[slot].vehicleId >= 0)
+            finish(slot, PathEnd::ON_GRID);
+    }
+    writeBlock();
+    file.close();
+}
+
+void PathRecorder::start(int slot, int vehicleId, int spawnStep) {
+    if (slot >= static_cast<int>(paths.size()))
+        paths.resize(slot + 1);
+    Path& path = paths[slot];
+    path.vehicleId = vehicleId;
+    path.spawnStep = spawnStep;
+    path.steps = 0;
+    path.moves.clear();
+}
+
+void PathRecorder::finish(int slot, PathEnd end) {
+    if (slot >= static_cast<int>(paths.size()) || paths[slot].vehicleId < 0)
+        return;
+    Path& path = paths[slot];
+
+    putVarint(block, static_cast<uint32_t>(path.vehicleId));
+    putVarint(block, zigzag(path.spawnStep - lastSpawn));
+    putVarint(block, static_cast<uint32_t>(path.x));
+    putVarint(block, static_cast<uint32_t>(path.y));
+    putVarint(block, static_cast<uint64_t>(path.steps) << 2 | static_cast<uint64_t>(end));
+    block += path.moves;
+    lastSpawn = path.spawnStep;
+    blockRecords++;
+
+    path.vehicleId = -1;
+    path.moves.clear();
+    if (block.size() >= BLOCK_SIZE)
+        writeBlock();
+}
+
+void PathRecorder::writeBlock() {
+    if (blockRecords == 0)
+        return;
+    BinaryIO::write(file, static_cast<uint32_t>(block.size()));
+    BinaryIO::write(file, blockRecords);
+    file.write(block.data(), static_cast<std::streamsize>(block.size()));
+    bytesWritten += 8 + block.size();
+
+    // Every block starts from scratch, so blocks decode independently
+    block.clear();
+    blockRecords = 0;
+    lastSpawn = 0;
+}
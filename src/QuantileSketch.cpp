@@ -0,0 +1,102 @@
+/**
+ * @file QuantileSketch.cpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#include "QuantileSketch.hpp"
+#include <algorithm>
+#include <cmath>
+
+int QuantileSketch::bucketOf(uint64_t value) {
+    if (value < LINEAR)
+        return static_cast<int>(value);
+
+    // Top 7 bits of the value select the bucket inside its power of two
+    int shift = 63 - __builtin_clzll(value) - 6;
+    return LINEAR + (shift - 1) * SUB + static_cast<int>((value >> shift) - SUB);
+}
+
+uint64_t QuantileSketch::lowerBound(int bucket) {
+    if (bucket < LINEAR)
+        return static_cast<uint64_t>(bucket);
+    int shift = (bucket - LINEAR) / SUB + 1;
+    return static_cast<uint64_t>((bucket - LINEAR) % SUB + SUB) << shift;
+}
+
+uint64_t QuantileSketch::width(int bucket) {
+    return bucket < LINEAR ? 1 : uint64_t{1} << ((bucket - LINEAR) / SUB + 1);
+}
+
+void QuantileSketch::add(long long value) {
+    value = std::max(value, 0LL);
+    int bucket = bucketOf(static_cast<uint64_t>(value));
+    if (bucket >= static_cast<int>(counts.size()))
+        counts.resize(bucket + 1, 0);
+    counts[bucket]++;
+
+    minValue = total == 0 ? value : std::min(minValue, value);
+    maxValue = total == 0 ? value : std::max(maxValue, value);
+    total++;
+    sum += value;
+}
+
+void QuantileSketch::remove(long long value) {
+    value = std::max(value, 0LL);
+    counts[bucketOf(static_cast<uint64_t>(value))]--;
+    total--;
+    sum -= value;
+    if (total == 0) {
+        clear();
+        return;
+    }
+
+    // The exact extremes are not kept, the outermost non-empty buckets bound them
+    int low = 0;
+    while (counts[low] == 0)
+        low++;
+    int high = static_cast<int>(counts.size()) - 1;
+    while (counts[high] == 0)
+        high--;
+    minValue = std::max(minValue, static_cast<long long>(lowerBound(low)));
+    maxValue = std::min(maxValue, static_cast<long long>(lowerBound(high) + width(high) - 1));
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    if (other.total == 0)
+        return;
+    if (other.counts.size() > counts.size())
+        counts.resize(other.counts.size(), 0);
+    for (size_t b = 0; b < other.counts.size(); b++)
+        counts[b] += other.counts[b];
+
+    minValue = total == 0 ? other.minValue : std::min(minValue, other.minValue);
+    maxValue = total == 0 ? other.maxValue : std::max(maxValue, other.maxValue);
+    total += other.total;
+    sum += other.sum;
+}
+
+double QuantileSketch::quantile(double q) const {
+    if (total == 0)
+        return 0.0;
+
+    // Bucket holding the value of rank ceil(q * total)
+    uint64_t rank = static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * total));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    int bucket = 0;
+    for (; bucket < static_cast<int>(counts.size()); bucket++) {
+        seen += counts[bucket];
+        if (seen >= rank)
+            break;
+    }
+
+    double mid = lowerBound(bucket) + (width(bucket) - 1) / 2.0;
+    return std::clamp(mid, static_cast<double>(minValue), static_cast<double>(maxValue));
+}
+
+void QuantileSketch::clear() {
+    counts.clear();
+    total = 0;
+    sum = 0;
+    minValue = 0;
+    maxValue = 0;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file SignalController.cpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#include "SignalController.hpp"
+#include <algorithm>
+
+void SignalController::clear() {
+    groups.clear();
+    states.clear();
+    events.clear();
+    changed.clear();
+    nextEvent = 0;
+    cycle = 0;
+    step = 0;
+    phase = 0;
+}
+
+int SignalController::addGroup(int start, int green, int yellow) {
+    groups.push_back({start, green, yellow});
+    states.push_back(SignalState::RED);
+    return static_cast<int>(groups.size()) - 1;
+}
+
+void SignalController::setCycle(int length) {
+    cycle = std::max(length, 1);
+
+    // Green, yellow and red start of every group, wrapped into the cycle
+    events.clear();
+    for (int g = 0; g < static_cast<int>(groups.size()); g++) {
+        const Group& group = groups[g];
+        for (int offset : {group.start, group.start + group.green - group.yellow, group.start + group.green})
+            events.push_back({((offset % cycle) + cycle) % cycle, g});
+    }
+    std::stable_sort(events.begin(), events.end(),
+                     [](const Event& a, const Event& b) { return a.offset < b.offset; });
+
+    setStep(0);
+}
+
+void SignalController::setStep(int at) {
+    step = at;
+    phase = cycle > 0 ? at % cycle : 0;
+    changed.clear();
+    for (int g = 0; g < static_cast<int>(groups.size()); g++)
+        states[g] = stateAt(g, phase);
+
+    // Events up to the current phase already fired, the rest wait for the next cycle
+    nextEvent = 0;
+    while (nextEvent < events.size() && events[nextEvent].offset <= phase)
+        nextEvent++;
+    if (nextEvent == events.size())
+        nextEvent = 0;
+}
+
+bool SignalController::advance() {
+    step++;
+    phase = phase + 1 == cycle ? 0 : phase + 1;
+    changed.clear();
+    if (events.empty() || events[nextEvent].offset != phase)
+        return false;
+
+    // Fire all events of this step (at most one cycle worth of them)
+    for (size_t fired = 0; fired < events.size() && events[nextEvent].offset == phase; fired++) {
+        int g = events[nextEvent].group;
+        SignalState state = stateAt(g, phase);
+        if (state != states[g]) {
+            states[g] = state;
+            changed.push_back(g);
+        }
+        nextEvent = (nextEvent + 1) % events.size();
+    }
+
+    return !changed.empty();
+}
+
+SignalState SignalController::stateAt(int group, int at) const {
+    const Group& g = groups[group];
+    int since = (((at - g.start) % cycle) + cycle) % cycle;
+    if (since < g.green - g.yellow)
+        return SignalState::GREEN;
+    if (since < g.green)
+        return SignalState::YELLOW;
+    return SignalState::RED;
+}
@@ -0,0 +1,256 @@
+/**
+ * @file SignalTuner.cpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#include "SignalTuner.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+namespace {
+
+/** Names of the tuned greens in search order (as in --sweep) */
+const char* const GREENS[] = {"northGreen", "southGreen", "westGreen", "eastGreen", "eastTurnGreen"};
+const int GREEN_COUNT = 5;
+
+/**
+ * @brief Vehicle-steps in the system per spawned vehicle (Little's law, cars stuck in a queue are not ignored)
+ */
+double delayOf(const SummaryStatistics& s) {
+    return s.totalCarsSpawned > 0 ? s.avgCarsInSystem * s.totalSteps / s.totalCarsSpawned : 0.0;
+}
+
+} // namespace
+
+SignalTuner::SignalTuner(const SimulationConfig& b, const TuningOptions& o)
+    : base(b), options(o), best(b.signals) {
+    options.replicas = std::max(options.replicas, 1);
+    options.checkpoints = std::max(options.checkpoints, 1);
+    options.minStep = std::max(options.minStep, 1);
+}
+
+bool SignalTuner::parseObjective(const std::string& name, TuningObjective& out) {
+    if (name == "throughput")  out = TuningObjective::Throughput;
+    else if (name == "delay")  out = TuningObjective::Delay;
+    else return false;
+    return true;
+}
+
+int& SignalTuner::green(SignalPlan& plan, int index) {
+    switch (index) {
+        case 0:  return plan.northGreen;
+        case 1:  return plan.southGreen;
+        case 2:  return plan.westGreen;
+        case 3:  return plan.eastStraightGreen;
+        default: return plan.eastTurnGreen;
+    }
+}
+
+double SignalTuner::cost(const SummaryStatistics& s) const {
+    return options.objective == TuningObjective::Throughput ? -s.throughputPerMinute : delayOf(s);
+}
+
+std::vector<TuningEvaluation> SignalTuner::evaluate(ThreadPool& pool, const std::vector<SignalPlan>& plans, int round,
+                                                    const std::vector<std::vector<double>>& reference,
+                                                    std::vector<std::vector<std::vector<double>>>& traces) const {
+    int candidates = static_cast<int>(plans.size());
+    int replicas = options.replicas;
+    int checkpoints = options.checkpoints;
+
+    struct Run {
+        std::vector<SummaryStatistics> summaries;  ///< Summary at each checkpoint reached
+        int failedAt = -1;                          ///< First checkpoint failing its own test (-1 if none)
+    };
+    std::vector<Run> runs(candidates * replicas);
+    traces.assign(candidates, std::vector<std::vector<double>>(replicas, std::vector<double>(checkpoints, 0.0)));
+
+    // Earliest failed checkpoint of each candidate so far. Replicas past it stop running, they already
+    // have their summary at the checkpoint the candidate is reported from, so this only saves steps
+    std::unique_ptr<std::atomic<int>[]> stopAt(new std::atomic<int>[candidates]);
+    for (int c = 0; c < candidates; c++)
+        stopAt[c] = checkpoints;
+
+    // The first quarter of a run is warm-up, queues are too short to compare plans
+    int firstCheck = checkpoints / 4;
+    auto until = [&](int k) { return static_cast<int>(static_cast<long long>(base.steps) * (k + 1) / checkpoints); };
+
+    pool.parallelFor(candidates * replicas, [&](int i) {
+        int c = i / replicas;
+        int r = i % replicas;
+        SimulationConfig config = base;
+        config.signals = plans[c];
+        config.seed = base.seed + static_cast<uint64_t>(r);
+
+        Run& run = runs[i];
+        Simulation sim(config);
+        for (int k = 0; k < checkpoints && k <= stopAt[c]; k++) {
+            while (sim.getStep() < until(k))
+                sim.step();
+            run.summaries.push_back(sim.getLogger().computeSummary());
+            double current = cost(run.summaries.back());
+            traces[c][r][k] = current;
+
+            if (reference.empty() || k + 1 == checkpoints)
+                continue;
+            double limit = reference[r][k] + options.margin * std::abs(reference[r][k]);
+            if (k >= firstCheck && current > limit) {
+                run.failedAt = k;
+                int earliest = stopAt[c];
+                while (k < earliest && !stopAt[c].compare_exchange_weak(earliest, k)) {}
+                break;
+            }
+        }
+    });
+
+    // A candidate is abandoned at the earliest checkpoint any of its replicas failed and reported from
+    // there, so the results are independent of scheduling
+    std::vector<TuningEvaluation> results(candidates);
+    for (int c = 0; c < candidates; c++) {
+        int at = checkpoints - 1;
+        for (int r = 0; r < replicas; r++) {
+            int failedAt = runs[c * replicas + r].failedAt;
+            if (failedAt >= 0)
+                at = std::min(at, failedAt);
+        }
+
+        TuningEvaluation& e = results[c];
+        e = TuningEvaluation{round, plans[c], 0.0, 0.0, 0.0, at + 1 < checkpoints, 0};
+        for (int r = 0; r < replicas; r++) {
+            const SummaryStatistics& summary = runs[c * replicas + r].summaries[at];
+            e.cost += cost(summary) / replicas;
+            e.throughput += summary.throughputPerMinute / replicas;
+            e.delay += delayOf(summary) / replicas;
+            e.stepsRun += until(at);
+        }
+    }
+    return results;
+}
+
+SignalPlan SignalTuner::run(ThreadPool& pool) {
+    evaluations.clear();
+
+    // Starting plan runs fully, its trace is what candidates are compared to
+    std::vector<std::vector<std::vector<double>>> traces;
+    TuningEvaluation start = evaluate(pool, {best}, 0, {}, traces).front();
+    evaluations.push_back(start);
+    bestCost = start.cost;
+    std::vector<std::vector<double>> reference = traces.front();
+
+    int step = options.initialStep;
+    int round = 1;
+    while (step >= options.minStep && static_cast<int>(evaluations.size()) < options.budget) {
+        // Neighbours of the incumbent along every green (both directions)
+        std::vector<SignalPlan> plans;
+        for (int g = 0; g < GREEN_COUNT; g++) {
+            for (int sign : {-1, 1}) {
+                SignalPlan plan = best;
+                int& value = green(plan, g);
+                int moved = std::clamp(value + sign * step, options.minGreen, options.maxGreen);
+                if (moved == value)
+                    continue;
+                value = moved;
+                plans.push_back(plan);
+            }
+        }
+        int left = options.budget - static_cast<int>(evaluations.size());
+        if (static_cast<int>(plans.size()) > left)
+            plans.resize(left);
+        if (plans.empty())
+            break;
+
+        std::vector<TuningEvaluation> results = evaluate(pool, plans, round, reference, traces);
+        int winner = -1;
+        for (int c = 0; c < static_cast<int>(results.size()); c++) {
+            evaluations.push_back(results[c]);
+            if (!results[c].abandoned && results[c].cost < bestCost) {
+                bestCost = results[c].cost;
+                winner = c;
+            }
+        }
+
+        std::cout << "Round " << round << " (step " << step << "): " << plans.size() << " plans, "
+                  << std::count_if(results.begin(), results.end(), [](const TuningEvaluation& e) { return e.abandoned; })
+                  << " abandoned, best cost " << std::fixed << std::setprecision(4) << bestCost << std::endl;
+
+        // Move to the best improvement (its full trace becomes the new reference) or refine the step
+        if (winner >= 0) {
+            best = plans[winner];
+            reference = traces[winner];
+        } else {
+            step /= 2;
+        }
+        round++;
+    }
+    return best;
+}
+
+void SignalTuner::printTable() const {
+    if (evaluations.empty())
+        return;
+
+    long long stepsRun = 0;
+    int abandoned = 0;
+    for (const TuningEvaluation& e : evaluations) {
+        stepsRun += e.stepsRun;
+        abandoned += e.abandoned;
+    }
+    long long fullSteps = static_cast<long long>(evaluations.size()) * options.replicas * base.steps;
+
+    const TuningEvaluation& start = evaluations.front();
+    SignalPlan startPlan = start.plan;
+    SignalPlan bestPlan = best;
+    auto bestEval = std::find_if(evaluations.begin(), evaluations.end(), [&](const TuningEvaluation& e) {
+        return !e.abandoned && e.cost == bestCost;
+    });
+
+    std::cout << "\nSignal Tuning Results (" << evaluations.size() << " plans, " << abandoned << " abandoned):\n";
+    std::cout << std::string(84, '-') << std::endl;
+    std::cout << std::left << std::setw(12) << "plan";
+    for (const char* name : GREENS)
+        std::cout << std::right << std::setw(14) << name;
+    std::cout << std::endl << std::string(84, '-') << std::endl;
+    std::cout << std::left << std::setw(12) << "start";
+    for (int g = 0; g < GREEN_COUNT; g++)
+        std::cout << std::right << std::setw(14) << green(startPlan, g);
+    std::cout << std::endl << std::left << std::setw(12) << "best";
+    for (int g = 0; g < GREEN_COUNT; g++)
+        std::cout << std::right << std::setw(14) << green(bestPlan, g);
+    std::cout << std::endl << std::string(84, '-') << std::endl;
+
+    std::cout << std::fixed << std::setprecision(4)
+              << "Throughput (veh/min)   " << std::setw(12) << start.throughput << " -> " << bestEval->throughput << std::endl
+              << "Delay (steps/veh)      " << std::setw(12) << start.delay << " -> " << bestEval->delay << std::endl
+              << "Simulated steps        " << std::setw(12) << stepsRun << " of " << fullSteps << " ("
+              << std::setprecision(1) << (fullSteps > 0 ? 100.0 * stepsRun / fullSteps : 0.0) << "%)" << std::endl;
+    std::cout << std::string(84, '-') << std::endl << std::endl;
+}
+
+void SignalTuner::exportCsv(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file) {
+        std::cerr << "Error: Cannot open file " << filename << std::endl;
+        return;
+    }
+
+    file << "evaluation,round";
+    for (const char* name : GREENS)
+        file << "," << name;
+    file << ",cost,throughputPerMinute,delay,abandoned,stepsRun\n";
+
+    for (size_t i = 0; i < evaluations.size(); i++) {
+        const TuningEvaluation& e = evaluations[i];
+        SignalPlan plan = e.plan;
+        file << i << "," << e.round;
+        for (int g = 0; g < GREEN_COUNT; g++)
+            file << "," << green(plan, g);
+        file << std::fixed << std::setprecision(4) << "," << e.cost << "," << e.throughput << "," << e.delay
+             << "," << (e.abandoned ? 1 : 0) << "," << e.stepsRun << "\n";
+    }
+
+    file.close();
+    std::cout << "Exported signal tuning results to: " << filename << std::endl;
+}
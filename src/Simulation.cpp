@@ -0,0 +1,142 @@
+/**
+ * @file Simulation.cpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#include "Simulation.hpp"
+#include "BinaryIO.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+const uint32_t CHECKPOINT_MAGIC = 0x4B435443;   ///< "CTCK" in a little-endian file
+const uint32_t CHECKPOINT_VERSION = 7;
+
+} // namespace
+
+Simulation::Simulation(const SimulationConfig& c)
+    : config(c), grid(c.width, c.height), steadyState(c.steadyTarget) {
+    grid.setSeed(config.seed);
+    grid.setInflowScale(config.inflow);
+    grid.setSignalPlan(config.signals);
+    grid.initializeMap(config.density, config.optimize);
+    grid.setupCrossroadLights(25, 0, 20);
+    logger.setKeepVehicleRecords(config.vehicleRecords);
+    logger.setSampling(config.sampling);
+    if (!config.headless)
+        grid.setLogger(&logger);
+}
+
+template <bool Logged>
+void Simulation::advance() {
+    // Common speed limits use an update with vmax fixed at compile time
+    switch (config.vmax) {
+        case 3:  grid.update<NSRules, 3, Logged>(rules, config.density, 3, config.prob, currentStep); break;
+        case 5:  grid.update<NSRules, 5, Logged>(rules, config.density, 5, config.prob, currentStep); break;
+        default: grid.update<NSRules, 0, Logged>(rules, config.density, config.vmax, config.prob, currentStep);
+    }
+}
+
+void Simulation::step() {
+    if (config.headless)
+        advance<false>();
+    else
+        advance<true>();
+    currentStep++;
+
+    // The summary always leaves out the warm-up found so far
+    if (steadyState.isEnabled() && logger.getLoggedSteps() > 0) {
+        steadyState.observe(logger.getLastTimestep());
+        logger.setWarmup(steadyState.getWarmupSteps());
+    }
+}
+
+SummaryStatistics Simulation::run() {
+    while (!finished())
+        step();
+    logger.finalizeData();
+    return summary();
+}
+
+SummaryStatistics Simulation::summary() const {
+    if (!config.headless)
+        return logger.computeSummary();
+
+    // Without logging only the grid counters are known
+    SummaryStatistics s;
+    s.totalSteps = currentStep;
+    s.totalCarsSpawned = grid.getCarsEntered();
+    s.totalCarsExited = grid.getCarsEntered() - grid.getCarsInSystem();
+    s.completionRate = s.totalCarsSpawned > 0 ? static_cast<double>(s.totalCarsExited) / s.totalCarsSpawned : 0.0;
+    s.throughputPerMinute = currentStep > 0 ? s.totalCarsExited * 60.0 / currentStep : 0.0;
+    return s;
+}
+
+bool Simulation::saveCheckpoint(const std::string& path) const {
+    std::string partial = path + ".tmp";
+    {
+        std::ofstream file(partial, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Error: Cannot open file " << partial << std::endl;
+            return false;
+        }
+        BinaryIO::write(file, CHECKPOINT_MAGIC);
+        BinaryIO::write(file, CHECKPOINT_VERSION);
+        BinaryIO::write(file, static_cast<uint8_t>(config.optimize));
+        BinaryIO::write(file, currentStep);
+        grid.save(file);
+        logger.save(file);
+        steadyState.save(file);
+        if (!file) {
+            std::cerr << "Error: Cannot write checkpoint " << partial << std::endl;
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(partial, path, error);
+    if (error) {
+        std::cerr << "Error: Cannot write checkpoint " << path << " (" << error.message() << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Simulation::restoreCheckpoint(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error: Cannot open file " << path << std::endl;
+        return false;
+    }
+
+    uint32_t magic = 0, version = 0;
+    uint8_t optimized = 0;
+    int step = 0;
+    if (!BinaryIO::read(file, magic) || magic != CHECKPOINT_MAGIC ||
+        !BinaryIO::read(file, version) || version != CHECKPOINT_VERSION) {
+        std::cerr << "Error: " << path << " is not a checkpoint of this version" << std::endl;
+        return false;
+    }
+    if (!BinaryIO::read(file, optimized) || !BinaryIO::read(file, step) ||
+        optimized != static_cast<uint8_t>(config.optimize) || !grid.load(file) || !logger.load(file) ||
+        !steadyState.load(file)) {
+        std::cerr << "Error: Checkpoint " << path << " is damaged or does not match the layout (width, height, --optimize)" << std::endl;
+        return false;
+    }
+    currentStep = step;
+
+    // A checkpoint written without warm-up detection only has the logged steps to rebuild it from
+    if (steadyState.isEnabled() && steadyState.getObserved() == 0 && step > 0) {
+        if (logger.timestepData.size() != static_cast<size_t>(step)) {
+            std::cerr << "Error: Checkpoint " << path << " was written without --steady-state and does not have "
+                      << "every step logged, the warm-up cannot be rebuilt" << std::endl;
+            return false;
+        }
+        for (const TimestepMetrics& metrics : logger.timestepData)
+            steadyState.observe(metrics);
+    }
+    if (steadyState.isEnabled())
+        logger.setWarmup(steadyState.getWarmupSteps());
+    return true;
+}
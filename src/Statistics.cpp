@@ -0,0 +1,46 @@
+/**
+ * @file Statistics.cpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#include "Statistics.hpp"
+#include <cmath>
+
+namespace {
+
+/**
+ * @brief Two-sided 95% quantile of Student's t distribution
+ */
+double tQuantile95(int df) {
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (df <= 30)
+        return table[df - 1];
+    // Cornish-Fisher expansion around the normal quantile
+    const double z = 1.959964;
+    return z + (z * z * z + z) / (4.0 * df);
+}
+
+} // namespace
+
+KpiEstimate estimateKpi(const std::vector<double>& samples) {
+    KpiEstimate est;
+    est.samples = static_cast<int>(samples.size());
+    if (samples.empty())
+        return est;
+
+    for (double x : samples)
+        est.mean += x;
+    est.mean /= est.samples;
+
+    if (est.samples < 2)
+        return est;
+
+    double sq = 0.0;
+    for (double x : samples)
+        sq += (x - est.mean) * (x - est.mean);
+    est.stddev = std::sqrt(sq / (est.samples - 1));
+    est.ciHalfWidth = tQuantile95(est.samples - 1) * est.stddev / std::sqrt(static_cast<double>(est.samples));
+    return est;
+}
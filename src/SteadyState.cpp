@@ -0,0 +1,121 @@
+/**
+ * @file SteadyState.cpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#include "SteadyState.hpp"
+#include "BinaryIO.hpp"
+#include <algorithm>
+#include <cmath>
+
+SteadyStateDetector::SteadyStateDetector(double t) : target(t) {}
+
+void SteadyStateDetector::reset() {
+    exits = Series{};
+    speeds = Series{};
+    observed = 0;
+    lastExited = 0;
+    warmupBatches = 0;
+    throughput = KpiEstimate{};
+    velocity = KpiEstimate{};
+    done = false;
+}
+
+void SteadyStateDetector::observe(const TimestepMetrics& metrics) {
+    exits.partial += metrics.carsExited - lastExited;
+    speeds.partial += metrics.avgVelocity;
+    lastExited = metrics.carsExited;
+    if (++observed % BATCH != 0)
+        return;
+
+    for (Series* series : {&exits, &speeds}) {
+        series->batches.push_back(series->partial / BATCH);
+        series->partial = 0.0;
+    }
+    if (isEnabled() && static_cast<int>(exits.batches.size()) % EVERY == 0)
+        evaluate();
+}
+
+int SteadyStateDetector::truncation(const Series& series) {
+    // MSER(d) = sum of squared deviations of batches d..n-1 / (n - d)^2, from suffix sums in O(n)
+    const std::vector<double>& x = series.batches;
+    int n = static_cast<int>(x.size());
+    double sum = 0.0, sumSq = 0.0;
+    double bestValue = 0.0;
+    int best = 0;
+    for (int d = n - 1; d >= 0; d--) {
+        sum += x[d];
+        sumSq += x[d] * x[d];
+        if (d > n / 2)
+            continue;
+        double count = n - d;
+        double value = (sumSq - sum * sum / count) / (count * count);
+        if (d == n / 2 || value <= bestValue) {
+            bestValue = value;
+            best = d;
+        }
+    }
+    return best;
+}
+
+KpiEstimate SteadyStateDetector::estimate(const Series& series) const {
+    int first = warmupBatches;
+    int n = static_cast<int>(series.batches.size()) - first;
+    int size = n / GROUPS;
+    if (size < 1)
+        return KpiEstimate{};
+
+    // Batches left over by the grouping are taken from the front of the steady part
+    std::vector<double> means;
+    for (int g = 0; g < GROUPS; g++) {
+        int from = first + (n - GROUPS * size) + g * size;
+        double sum = 0.0;
+        for (int i = from; i < from + size; i++)
+            sum += series.batches[i];
+        means.push_back(sum / size);
+    }
+    return estimateKpi(means);
+}
+
+void SteadyStateDetector::evaluate() {
+    warmupBatches = std::max(truncation(exits), truncation(speeds));
+    throughput = estimate(exits);
+    velocity = estimate(speeds);
+    checkConverged();
+}
+
+void SteadyStateDetector::checkConverged() {
+    int batches = static_cast<int>(exits.batches.size());
+    auto precise = [&](const KpiEstimate& kpi) {
+        return kpi.samples == GROUPS && kpi.ciHalfWidth <= target * std::abs(kpi.mean);
+    };
+    done = batches >= MIN_BATCHES && precise(throughput) && precise(velocity);
+}
+
+void SteadyStateDetector::save(std::ostream& out) const {
+    for (const Series* series : {&exits, &speeds}) {
+        BinaryIO::writeVector(out, series->batches);
+        BinaryIO::write(out, series->partial);
+    }
+    BinaryIO::write(out, observed);
+    BinaryIO::write(out, lastExited);
+    BinaryIO::write(out, warmupBatches);
+    BinaryIO::write(out, throughput);
+    BinaryIO::write(out, velocity);
+}
+
+bool SteadyStateDetector::load(std::istream& in) {
+    Series restored[2];
+    for (Series& series : restored) {
+        if (!BinaryIO::readVector(in, series.batches) || !BinaryIO::read(in, series.partial))
+            return false;
+    }
+    if (!BinaryIO::read(in, observed) || !BinaryIO::read(in, lastExited) || !BinaryIO::read(in, warmupBatches) ||
+        !BinaryIO::read(in, throughput) || !BinaryIO::read(in, velocity))
+        return false;
+    exits = std::move(restored[0]);
+    speeds = std::move(restored[1]);
+    done = false;
+    if (isEnabled())
+        checkConverged();
+    return true;
+}
@@ -0,0 +1,226 @@
+/**
+ * @file Sweep.cpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#include "Sweep.hpp"
+#include "Ensemble.hpp"
+#include "NaschKernel.hpp"
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+Sweep::Sweep(const SimulationConfig& b) : base(b) {}
+
+const char* Sweep::parameterNames() {
+    return "density, prob, vmax, steps, width, height, inflow, optimize, "
+           "northGreen, southGreen, westGreen, eastGreen, eastTurnGreen";
+}
+
+bool Sweep::applyParameter(SimulationConfig& config, const std::string& name, double value) {
+    int rounded = static_cast<int>(std::lround(value));
+    if (name == "density")            config.density = value;
+    else if (name == "prob")          config.prob = value;
+    else if (name == "vmax")          config.vmax = rounded;
+    else if (name == "steps")         config.steps = rounded;
+    else if (name == "width")         config.width = rounded;
+    else if (name == "height")        config.height = rounded;
+    else if (name == "inflow")        config.inflow = value;
+    else if (name == "optimize")      config.optimize = rounded != 0;
+    else if (name == "northGreen")    config.signals.northGreen = rounded;
+    else if (name == "southGreen")    config.signals.southGreen = rounded;
+    else if (name == "westGreen")     config.signals.westGreen = rounded;
+    else if (name == "eastGreen")     config.signals.eastStraightGreen = rounded;
+    else if (name == "eastTurnGreen") config.signals.eastTurnGreen = rounded;
+    else return false;
+    return true;
+}
+
+bool Sweep::addParameter(const std::string& spec) {
+    size_t eq = spec.find('=');
+    if (eq == std::string::npos || eq == 0 || eq + 1 == spec.size()) {
+        std::cerr << "Error: Invalid sweep '" << spec << "', expected name=from:to:step or name=v1,v2,..." << std::endl;
+        return false;
+    }
+
+    SweepParameter param;
+    param.name = spec.substr(0, eq);
+    SimulationConfig probe = base;
+    if (!applyParameter(probe, param.name, 0.0)) {
+        std::cerr << "Error: Unknown sweep parameter '" << param.name << "' (one of: " << parameterNames() << ")" << std::endl;
+        return false;
+    }
+
+    std::string values = spec.substr(eq + 1);
+    try {
+        if (values.find(':') != std::string::npos) {
+            std::istringstream ss(values);
+            std::string from, to, step;
+            std::getline(ss, from, ':');
+            std::getline(ss, to, ':');
+            std::getline(ss, step);
+            double a = std::stod(from), b = std::stod(to), d = std::stod(step);
+            if (d <= 0.0 || b < a)
+                throw std::invalid_argument(values);
+            // Count steps instead of accumulating, so the end point is not lost to rounding
+            int count = static_cast<int>(std::floor((b - a) / d + 1e-9)) + 1;
+            for (int i = 0; i < count; i++)
+                param.values.push_back(a + i * d);
+        } else {
+            std::istringstream ss(values);
+            std::string value;
+            while (std::getline(ss, value, ','))
+                param.values.push_back(std::stod(value));
+        }
+    } catch (...) {
+        std::cerr << "Error: Invalid values in sweep '" << spec << "'" << std::endl;
+        return false;
+    }
+
+    if (param.values.empty()) {
+        std::cerr << "Error: No values in sweep '" << spec << "'" << std::endl;
+        return false;
+    }
+    for (double value : param.values) {
+        if (param.name == "vmax" && (std::lround(value) < 0 || std::lround(value) > NaschKernel::MAX_VMAX)) {
+            std::cerr << "Error: vmax in sweep '" << spec << "' must be between 0 and " << NaschKernel::MAX_VMAX << std::endl;
+            return false;
+        }
+    }
+    parameters.push_back(param);
+    return true;
+}
+
+bool Sweep::loadFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Error: Cannot open file " << path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        line.erase(0, line.find_first_not_of(" \t\r"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (!line.empty() && !addParameter(line))
+            return false;
+    }
+    return true;
+}
+
+int Sweep::points() const {
+    int count = 1;
+    for (const SweepParameter& param : parameters)
+        count *= static_cast<int>(param.values.size());
+    return count;
+}
+
+std::vector<double> Sweep::pointValues(int point) const {
+    // The last parameter varies fastest
+    std::vector<double> values(parameters.size());
+    for (int p = static_cast<int>(parameters.size()) - 1; p >= 0; p--) {
+        int n = static_cast<int>(parameters[p].values.size());
+        values[p] = parameters[p].values[point % n];
+        point /= n;
+    }
+    return values;
+}
+
+SimulationConfig Sweep::pointConfig(int point) const {
+    SimulationConfig config = base;
+    std::vector<double> values = pointValues(point);
+    for (size_t p = 0; p < parameters.size(); p++)
+        applyParameter(config, parameters[p].name, values[p]);
+    return config;
+}
+
+void Sweep::run(ThreadPool& pool, int replicas) {
+    int total = points() * replicas;
+    runs.assign(total, SweepRun{});
+    for (int i = 0; i < total; i++) {
+        runs[i].point = i / replicas;
+        runs[i].replica = i % replicas;
+        runs[i].config = pointConfig(runs[i].point);
+        runs[i].config.seed = base.seed + static_cast<uint64_t>(runs[i].replica);
+    }
+
+    // Runs differ a lot in cost (steps, grid size), idle threads steal from busy ones
+    pool.parallelFor(total, [&](int i) {
+        SweepRun& run = runs[i];
+        auto start = std::chrono::steady_clock::now();
+        Simulation sim(run.config);
+        run.summary = sim.run();
+        int roadCells = sim.getGrid().getRoadCells();
+        run.measuredDensity = roadCells > 0 ? run.summary.avgCarsInSystem / roadCells : 0.0;
+        run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    });
+}
+
+void Sweep::printTable() const {
+    int width = 12 * static_cast<int>(parameters.size()) + 72;
+    std::cout << "\nSweep Results (" << points() << " points, " << runs.size() << " runs):\n";
+    std::cout << std::string(width, '-') << std::endl;
+    for (const SweepParameter& param : parameters)
+        std::cout << std::right << std::setw(12) << param.name;
+    std::cout << std::setw(12) << "density" << std::setw(12) << "flow/min" << std::setw(12) << "CI95 +/-"
+              << std::setw(12) << "avgVel" << std::setw(12) << "timeInSys" << std::setw(12) << "maxQueue" << std::endl;
+    std::cout << std::string(width, '-') << std::endl;
+
+    size_t i = 0;
+    while (i < runs.size()) {
+        int point = runs[i].point;
+        std::vector<double> density, flow, velocity, time, queue;
+        for (; i < runs.size() && runs[i].point == point; i++) {
+            density.push_back(runs[i].measuredDensity);
+            flow.push_back(runs[i].summary.throughputPerMinute);
+            velocity.push_back(runs[i].summary.avgVelocity);
+            time.push_back(runs[i].summary.avgTimeInSystem);
+            queue.push_back(runs[i].summary.maxQueueLength);
+        }
+
+        std::ostringstream values;
+        for (double value : pointValues(point))
+            values << std::setw(12) << std::defaultfloat << value;
+
+        KpiEstimate f = estimateKpi(flow);
+        std::cout << values.str() << std::fixed << std::setprecision(4)
+                  << std::setw(12) << estimateKpi(density).mean << std::setw(12) << f.mean << std::setw(12) << f.ciHalfWidth
+                  << std::setw(12) << estimateKpi(velocity).mean << std::setw(12) << estimateKpi(time).mean
+                  << std::setw(12) << estimateKpi(queue).mean << std::endl;
+    }
+    std::cout << std::string(width, '-') << std::endl << std::endl;
+}
+
+void Sweep::exportCsv(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file) {
+        std::cerr << "Error: Cannot open file " << filename << std::endl;
+        return;
+    }
+
+    file << "run,point,replica,seed";
+    for (const SweepParameter& param : parameters)
+        file << "," << param.name;
+    file << ",measuredDensity,throughputPerMinute,totalCarsSpawned,totalCarsExited,completionRate,"
+         << "avgVelocity,avgStoppedCars,avgCarsInSystem,maxQueueLength,avgTimeInSystem,avgWaitingTime,runtimeSeconds\n";
+
+    for (size_t i = 0; i < runs.size(); i++) {
+        const SweepRun& run = runs[i];
+        file << i << "," << run.point << "," << run.replica << "," << run.config.seed;
+        for (double value : pointValues(run.point))
+            file << "," << std::defaultfloat << value;
+
+        const SummaryStatistics& s = run.summary;
+        file << std::fixed << std::setprecision(4) << "," << run.measuredDensity << "," << s.throughputPerMinute
+             << "," << s.totalCarsSpawned << "," << s.totalCarsExited << "," << s.completionRate
+             << "," << s.avgVelocity << "," << s.avgStoppedCars << "," << s.avgCarsInSystem
+             << "," << s.maxQueueLength << "," << s.avgTimeInSystem << "," << s.avgWaitingTime
+             << "," << run.seconds << "\n";
+    }
+
+    file.close();
+    std::cout << "Exported sweep results to: " << filename << std::endl;
+}
@@ -0,0 +1,109 @@
+/**
+ * @file ThreadPool.cpp
+ * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
+ */
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int threads) {
+    for (int i = 0; i < std::max(threads, 1); i++)
+        queues.push_back(std::make_unique<WorkQueue>());
+    for (int i = 1; i < threads; i++)
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::parallelFor(int n, const std::function<void(int)>& fn) {
+    if (workers.empty() || n <= 1) {
+        for (int i = 0; i < n; i++)
+            fn(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &fn;
+
+        // Contiguous blocks keep neighbouring tasks (e.g. lanes) on one thread
+        int threads = size();
+        for (int t = 0; t < threads; t++) {
+            std::lock_guard<std::mutex> queueLock(queues[t]->mutex);
+            queues[t]->begin = static_cast<int>(static_cast<int64_t>(n) * t / threads);
+            queues[t]->end = static_cast<int>(static_cast<int64_t>(n) * (t + 1) / threads);
+        }
+
+        busy = static_cast<int>(workers.size());
+        generation++;
+    }
+    wake.notify_all();
+
+    runTasks(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busy == 0; });
+    job = nullptr;
+}
+
+int ThreadPool::pop(int self) {
+    WorkQueue& queue = *queues[self];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    return queue.begin < queue.end ? queue.begin++ : -1;
+}
+
+bool ThreadPool::steal(int self) {
+    int threads = size();
+    for (int k = 1; k < threads; k++) {
+        WorkQueue& victim = *queues[(self + k) % threads];
+        int begin, end;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            int left = victim.end - victim.begin;
+            if (left <= 0) continue;
+            end = victim.end;
+            begin = victim.end - (left + 1) / 2;
+            victim.end = begin;
+        }
+
+        WorkQueue& own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.begin = begin;
+        own.end = end;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::runTasks(int self) {
+    do {
+        for (int i = pop(self); i >= 0; i = pop(self))
+            (*job)(i);
+    } while (steal(self));
+}
+
+void ThreadPool::workerLoop(int self) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+
+        runTasks(self);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy == 0)
+            done.notify_one();
+    }
+}
@@ -113,16 +113,17 @@ void Utils::exportPPM(const Grid& grid, const std::string& filename, int scale,
             unsigned char r, g, b;
 
             const Cell& c = grid.getCell(cellY, cellX);
+            const Car* car = grid.getCar(cellY, cellX);
 
             if (c.hasTrafficLight()) {
-                switch (c.getTrafficLightState()) {
-                    case TrafficLight::RED:    r=255; g=0;   b=0;   break;
-                    case TrafficLight::YELLOW: r=255; g=255; b=0;   break;
-                    case TrafficLight::GREEN:  r=0;   g=255; b=0;   break;
+                switch (grid.getSignalState(c)) {
+                    case SignalState::RED:    r=255; g=0;   b=0;   break;
+                    case SignalState::YELLOW: r=255; g=255; b=0;   break;
+                    case SignalState::GREEN:  r=0;   g=255; b=0;   break;
                 }
             }
-            else if (c.hasCar()) {
-                int vel = c.getCarVelocity();
+            else if (car) {
+                int vel = car->velocity;
                 auto [rr, gg, bb] = Utils::velocityColormap(vel, vmax, Colormap::Turbo);
                 r = rr; g = gg; b = bb;
             }
@@ -171,13 +172,14 @@ void Utils::exportSmoothPPM(const Grid& grid,
     // Map current cars
     for (int y = 0; y < height; y++) {
         for (int x = 0; x < width; x++) {
-            const Cell& c = grid.getCell(y, x);
-            if (c.hasCar()) {
-                posNow[c.getCarId()] = {x, y};
-                velMap[c.getCarId()] = c.getCarVelocity();
+            const Car* c = grid.getCar(y, x);
+            if (c) {
+                posNow[c->id] = {x, y};
+                velMap[c->id] = c->velocity;
             }
-            if (nextGrid.getCell(y, x).hasCar()) {
-                posNext[nextGrid.getCell(y, x).getCarId()] = {x, y};
+            const Car* n = nextGrid.getCar(y, x);
+            if (n) {
+                posNext[n->id] = {x, y};
             }
         }
     }
@@ -216,10 +218,10 @@ void Utils::exportSmoothPPM(const Grid& grid,
             const Cell& c = grid.getCell(cy, cx);
 
             if (c.hasTrafficLight()) {
-                switch (c.getTrafficLightState()) {
-                    case TrafficLight::RED:    r=255; g=0;   b=0;   break;
-                    case TrafficLight::YELLOW: r=255; g=255; b=0;   break;
-                    case TrafficLight::GREEN:  r=0;   g=255; b=0;   break;
+                switch (grid.getSignalState(c)) {
+                    case SignalState::RED:    r=255; g=0;   b=0;   break;
+                    case SignalState::YELLOW: r=255; g=255; b=0;   break;
+                    case SignalState::GREEN:  r=0;   g=255; b=0;   break;
                 }
             }
             else if (carAt[cy][cx] != -1) {
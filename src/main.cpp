@@ -2,8 +2,10 @@
  * @file main.cpp
  * @authors Michal Repcik (xrepcim00), Adam Vesely (xvesela00)
  */
-#include "Grid.hpp"
-#include "Rules.hpp"
+#include "Simulation.hpp"
+#include "Ensemble.hpp"
+#include "Sweep.hpp"
+#include "SignalTuner.hpp"
 #include "ArgParser.hpp"
 #include "Utils.hpp"
 #include "Logger.hpp"
@@ -11,31 +13,147 @@
 #include <sstream>
 #include <iomanip>
 #include <iostream>
-#include <ctime>
 #include <cmath>
 #include <map>
 
+/**
+ * @brief Runs replicas of the configured scenario and reports their confidence intervals
+ */
+static int runEnsemble(const ArgParser& parser, const SimulationConfig& config) {
+    if (parser.isVizEnabled())
+        std::cerr << "Warning: --viz is ignored with replicas" << std::endl;
+
+    ThreadPool pool(parser.getJobs());
+    Ensemble ensemble(config, pool);
+    ensemble.addReplicas(parser.getReplicas());
+    if (parser.getCiTarget() > 0.0 && !ensemble.runUntil(parser.getCiTarget(), parser.getMaxReplicas()))
+        std::cerr << "Warning: CI target not reached after " << ensemble.getReplicas().size() << " replicas" << std::endl;
+    ensemble.printTable();
+
+    if (parser.isPlotEnabled()) {
+        std::string plotSubDir = parser.getOptimize() ? "modified" : "baseline";
+        ensemble.exportAll(parser.getPlotDir() + "/" + plotSubDir);
+    }
+    return 0;
+}
+
+/**
+ * @brief Runs every combination of the swept parameters and writes one consolidated table
+ */
+static int runSweep(const ArgParser& parser, const SimulationConfig& config) {
+    if (parser.isVizEnabled())
+        std::cerr << "Warning: --viz is ignored with --sweep" << std::endl;
+
+    Sweep sweep(config);
+    if (!parser.getSweepFile().empty() && !sweep.loadFile(parser.getSweepFile()))
+        return 1;
+    for (const std::string& spec : parser.getSweepSpecs()) {
+        if (!sweep.addParameter(spec))
+            return 1;
+    }
+
+    ThreadPool pool(parser.getJobs());
+    sweep.run(pool, parser.getReplicas());
+    sweep.printTable();
+
+    std::filesystem::create_directories(parser.getPlotDir());
+    sweep.exportCsv(parser.getPlotDir() + "/sweep_results.csv");
+    return 0;
+}
+
+/**
+ * @brief Searches green durations for the configured objective and exports every evaluated plan
+ */
+static int runTuning(const ArgParser& parser, const SimulationConfig& config) {
+    if (parser.isVizEnabled())
+        std::cerr << "Warning: --viz is ignored with --tune-signals" << std::endl;
+
+    TuningOptions options;
+    SignalTuner::parseObjective(parser.getTuneObjective(), options.objective);
+    options.replicas = parser.getReplicas();
+    options.initialStep = parser.getTuneStep();
+    options.budget = parser.getTuneBudget();
+
+    ThreadPool pool(parser.getJobs());
+    SignalTuner tuner(config, options);
+    tuner.run(pool);
+    tuner.printTable();
+
+    std::filesystem::create_directories(parser.getPlotDir());
+    tuner.exportCsv(parser.getPlotDir() + "/signal_tuning.csv");
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
-    srand(static_cast<unsigned>(time(nullptr)));
     ArgParser parser(static_cast<size_t>(argc), argv);
     if (!parser.parse())
         return 1;
+    std::cout << "Seed: " << parser.getSeed() << std::endl;
 
     if (parser.isVizEnabled())
         std::filesystem::create_directories(parser.getVizDir());
     if (parser.isPlotEnabled())
         std::filesystem::create_directories(parser.getPlotDir());
+
+    SimulationConfig config;
+    config.width = parser.getWidth();
+    config.height = parser.getHeight();
+    config.steps = parser.getSteps();
+    config.vmax = parser.getVMax();
+    config.prob = parser.getProb();
+    config.density = parser.getDensity();
+    config.optimize = parser.getOptimize();
+    config.seed = parser.getSeed();
+    config.steadyTarget = parser.getSteadyTarget();
+    config.sampling.stride = parser.getLogEvery();
+    config.sampling.vehicleRate = parser.getSampleVehicles();
+    for (const std::array<int, 4>& r : parser.getHeatmapRegions())
+        config.sampling.regions.push_back(SpatialRegion{r[0], r[1], r[2], r[3]});
+
+    if ((parser.isTuneEnabled() || parser.isSweepEnabled() || parser.isEnsembleEnabled()) &&
+        (parser.getCheckpointEvery() > 0 || !parser.getRestoreFile().empty()))
+        std::cerr << "Warning: checkpoints are only used by single runs" << std::endl;
+    if (parser.isTuneEnabled())
+        return runTuning(parser, config);
+    if (parser.isSweepEnabled())
+        return runSweep(parser, config);
+    if (parser.isEnsembleEnabled())
+        return runEnsemble(parser, config);
+
+    config.headless = parser.isHeadless();
+    // Streamed trajectories are written as vehicles leave, there is no need to keep them
+    config.vehicleRecords = parser.isPlotEnabled() && !parser.isStreamEnabled();
+    Simulation sim(config);
+    Grid& grid = sim.getGrid();
+    Logger& logger = sim.getLogger();
+    std::string exportDir = parser.getPlotDir() + "/" + (parser.getOptimize() ? "modified" : "baseline");
+    logger.setColumnarExport(parser.isColumnarEnabled());
+
+    if (!parser.getPathsFile().empty() && !logger.startPaths(parser.getPathsFile()))
+        return 1;
+    if (parser.isStreamEnabled()) {
+        // Warm-up truncation still needs the step history
+        logger.setKeepTimesteps(config.steadyTarget > 0.0);
+        if (!logger.startStreaming(exportDir))
+            return 1;
+    }
+
+    if (!parser.getRestoreFile().empty()) {
+        if (!sim.restoreCheckpoint(parser.getRestoreFile()))
+            return 1;
+        std::cout << "Restored step " << sim.getStep() << " from " << parser.getRestoreFile() << std::endl;
+    }
+
+    ThreadPool pool(parser.getThreads());
+    if (pool.size() > 1)
+        grid.setThreadPool(&pool);
     
-    Grid grid(parser.getWidth(), parser.getHeight());
-    grid.initializeMap(parser.getDensity(), parser.getOptimize());
-    grid.setupCrossroadLights(25, 0, 20);
-    
-    NSRules rules;
-    Logger logger;
-    grid.setLogger(&logger);
-    
-    for (int step = 0; step < parser.getSteps(); step++) {
-        grid.update(rules, parser.getDensity(), parser.getVMax(), parser.getProb(), step);
+    for (int step = sim.getStep(); step < parser.getSteps(); step++) {
+        sim.step();
+
+        if (parser.getCheckpointEvery() > 0 && sim.getStep() % parser.getCheckpointEvery() == 0 &&
+            !sim.saveCheckpoint(parser.getCheckpointFile()))
+            return 1;
         
         if (parser.isVizEnabled()) {
             std::ostringstream ss;
@@ -43,29 +161,54 @@ int main(int argc, char* argv[]) {
             Utils::exportPPM(grid, ss.str(), 10, parser.getVMax()); 
         }
 
-        if (step % 25 == 0 || step == parser.getSteps() - 1) {
-            logger.finalizeData();
+        if (config.headless)
+            continue;
+
+        // The summary comes from running totals, printing it does not walk the logged data
+        int every = parser.getReportEvery();
+        if ((every > 0 && step % every == 0) || step == parser.getSteps() - 1 || sim.reachedSteadyState())
             logger.printSummaryTable();
+
+        if (sim.reachedSteadyState()) {
+            std::cout << "Steady state reached at step " << sim.getStep() << " (warm-up "
+                      << sim.getSteadyState().getWarmupSteps() << " steps)" << std::endl;
+            break;
         }
+    }
+
+    if (config.headless) {
+        SummaryStatistics summary = sim.summary();
+        std::cout << "Headless run: " << summary.totalSteps << " steps, " << summary.totalCarsSpawned << " cars spawned, "
+                  << summary.totalCarsExited << " exited, " << std::fixed << std::setprecision(4)
+                  << summary.throughputPerMinute << " veh/min" << std::endl;
+    }
 
+    if (!parser.getPathsFile().empty()) {
+        uint64_t bytes = logger.stopPaths();
+        std::cout << "Recorded vehicle paths to: " << parser.getPathsFile() << " (" << bytes << " bytes)" << std::endl;
     }
 
     if (parser.isPlotEnabled()) {
         std::cout << "\nFinalizing and exporting data..." << std::endl;
-        std::string plotSubDir = parser.getOptimize() ? "modified" : "baseline";
-        std::string exportDir = parser.getPlotDir() + "/" + plotSubDir;
         std::filesystem::create_directories(exportDir);
-        grid.logDirectionMetrics(parser.getSteps() - 1);
+        grid.logDirectionMetrics(sim.getStep() - 1);
         logger.finalizeData();
+        bool streamed = logger.stopStreaming();
         logger.exportAll(exportDir);
+        if (!streamed) {
+            std::cerr << "Error: Data export incomplete, streamed files are truncated" << std::endl;
+            return 1;
+        }
         std::cout << "Data export complete!" << std::endl;
         std::cout << "\nGenerated files in '" << exportDir << "':" << std::endl;
-        std::cout << "  - timestep_metrics.csv" << std::endl;
-        std::cout << "  - vehicle_trajectories.csv" << std::endl;
+        const char* extension = parser.isColumnarEnabled() ? ".col" : ".csv";
+        std::cout << "  - timestep_metrics" << extension << std::endl;
+        std::cout << "  - vehicle_trajectories" << extension << std::endl;
         std::cout << "  - spatial_heatmap.csv" << std::endl;
         std::cout << "  - direction_metrics.csv" << std::endl;
         std::cout << "  - summary_statistics.csv" << std::endl;
+        std::cout << "  - delay_quantiles.csv" << std::endl;
     } 
         
     return 0;
-}
\ No newline at end of file
+}